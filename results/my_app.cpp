@@ -1,101 +1,296 @@
-// Mon May 23 17:37:55 2022
+// Sun Oct 18 15:10:39 2026
 
 #include<vector>
 #include<iostream>
+#include<limits>
+#include<cstdint>
+#include<cstring>
+#include<algorithm>
 
 int main() {
 
-	std::vector<float> data;
-	auto res = .0f;
+	std::vector<float> c_data;
+	std::vector<double> c_prices;
+	std::vector<float> c_ramp;
+	std::vector<std::int64_t> c_ramp_histogram;
+	std::vector<float> c_signal;
+	double r_prices_max = 0.0;
+	double r_prices_mean = 0.0;
+	double r_prices_variance = 0.0;
+	double r_ramp_total = 0.0;
+	double r_res = 0.0;
+	double r_signal_sum = 0.0;
+	double r_total = 0.0;
+
+	const auto _cleanup = [&]() {
+		c_data.clear();
+		c_data.shrink_to_fit();
+		c_prices.clear();
+		c_prices.shrink_to_fit();
+		c_ramp.clear();
+		c_ramp.shrink_to_fit();
+		c_ramp_histogram.clear();
+		c_ramp_histogram.shrink_to_fit();
+		c_signal.clear();
+		c_signal.shrink_to_fit();
+	};
 
 	// hello_world
 	std::cout << "Hello World !\n";
 
 	// print_number
 	// num : 42
-	std::cout<<"Number: "<<42.000000<<"\n";
+	std::cout<<"Number: "<<42.0<<"\n";
 
 	// set_values
 	// cnt : 0
-	data.clear();
+	c_data.clear();
 
 	{
 		// set_values
 		// cnt : 10
-		const auto cnt = 10;
-		data.resize(cnt);
-		for (auto i = 0; i < cnt; ++i) {data[i] = static_cast<float>(i);}
+		const auto cnt = 10LL;
+		c_data.resize(cnt);
+		for (auto i = 0LL; i < cnt; ++i) {c_data[i] = static_cast<float>(i);}
 	}
 
 	{
 		// check_data
-		const auto populated = !data.empty();
+		const auto populated = !c_data.empty();
 		if (!populated) {
-			// cleanup
-			data.clear();
-			data.shrink_to_fit();
+			_cleanup();
 			return 0;
 		}
 	}
 
 	// sum
-	res = 0.0f;
-	for (const auto&v:data) {res += v;}
+	r_res = 0.0;
+	for (const auto&v:c_data) {r_res += v;}
 
 	// print
-	std::cout << "Result: " << res <<"\n";
+	std::cout << "Result: " << r_res <<"\n";
 
 	{
 		// check
 		// ref : 45
-		const auto expected_value = 45.000000f;
-		const auto res_ok = expected_value == res;
+		const auto expected_value = 45.0;
+		const auto res_ok = expected_value == r_res;
 		if (!res_ok) {
-			// cleanup
-			data.clear();
-			data.shrink_to_fit();
+			_cleanup();
 			return 0;
 		}
 	}
 
 	// reset
-	data.clear();
-	res = 0.0f;
+	c_data.clear();
+	r_res = 0.0;
 
 	{
 		// set_values
 		// cnt : 20
-		const auto cnt = 20;
-		data.resize(cnt);
-		for (auto i = 0; i < cnt; ++i) {data[i] = static_cast<float>(i);}
+		const auto cnt = 20LL;
+		c_data.resize(cnt);
+		for (auto i = 0LL; i < cnt; ++i) {c_data[i] = static_cast<float>(i);}
 	}
 
 	{
 		// check_data
-		const auto populated = !data.empty();
+		const auto populated = !c_data.empty();
 		if (!populated) {
-			// cleanup
-			data.clear();
-			data.shrink_to_fit();
+			_cleanup();
 			return 0;
 		}
 	}
 
 	// print_data
 	std::cout << "Data :\n";
-	for (const auto& v : data)
+	for (const auto& v : c_data)
 		std::cout << v << "\n";
 
 	// product
-	res = 1.0f;
-	for (const auto&v:data) {res *= v;}
+	r_res = 1.0;
+	for (const auto&v:c_data) {r_res *= v;}
+
+	// print
+	std::cout << "Result: " << r_res <<"\n";
+
+	{
+		// set_values
+		// cnt : 5
+		// column : prices
+		// type : f64
+		const auto cnt = 5LL;
+		c_prices.resize(cnt);
+		for (auto i = 0LL; i < cnt; ++i) {c_prices[i] = static_cast<double>(i);}
+	}
+
+	// sum
+	// column : prices
+	// result : total
+	r_total = 0.0;
+	for (const auto&v:c_prices) {r_total += v;}
+
+	// print
+	// result : total
+	std::cout << "Result: " << r_total <<"\n";
+
+	{
+		// reduce
+		// column : prices
+		// max : 1
+		// mean : 1
+		// variance : 1
+		const auto n = c_prices.size();
+		auto sum = 0.0;
+		auto lo = std::numeric_limits<double>::infinity(), hi = -lo;
+		auto dev = 0.0, sq = 0.0;
+		const auto shift = 0 < n ? static_cast<double>(c_prices[0]) : 0.0;
+		for (auto i = std::size_t {0}; i < n; ++i) {
+			const auto x = static_cast<double>(c_prices[i]);
+			sum += x;
+			lo = x < lo ? x : lo;
+			hi = x > hi ? x : hi;
+			const auto d = x - shift;
+			dev += d;
+			sq += d * d;
+		}
+		r_prices_max = hi;
+		r_prices_mean = n > 0 ? sum / n : 0.0;
+		r_prices_variance = n > 0 ? (sq - dev * dev / n) / n : 0.0;
+	}
+
+	// print
+	// result : prices_mean
+	std::cout << "Result: " << r_prices_mean <<"\n";
+
+	// print
+	// result : prices_variance
+	std::cout << "Result: " << r_prices_variance <<"\n";
+
+	// print
+	// result : prices_max
+	std::cout << "Result: " << r_prices_max <<"\n";
+
+	{
+		// set_values
+		// cnt : 1000
+		// column : signal
+		const auto cnt = 1000LL;
+		c_signal.resize(cnt);
+		for (auto i = 0LL; i < cnt; ++i) {c_signal[i] = static_cast<float>(i);}
+	}
+
+	// scale
+	// column : signal
+	// value : 0.5
+	for (auto& v : c_signal) {v = static_cast<float>(v * 0.5);}
+
+	// offset
+	// column : signal
+	// value : 1
+	for (auto& v : c_signal) {v = static_cast<float>(v + 1.0);}
+
+	{
+		// reduce
+		// column : signal
+		// sum : 1
+		const auto n = c_signal.size();
+		auto sum = 0.0;
+		for (auto i = std::size_t {0}; i < n; ++i) {
+			const auto x = static_cast<double>(c_signal[i]);
+			sum += x;
+		}
+		r_signal_sum = sum;
+	}
+
+	// print
+	// result : signal_sum
+	std::cout << "Result: " << r_signal_sum <<"\n";
+
+	{
+		// set_values
+		// cnt : 8
+		// column : ramp
+		const auto cnt = 8LL;
+		c_ramp.resize(cnt);
+		for (auto i = 0LL; i < cnt; ++i) {c_ramp[i] = static_cast<float>(i);}
+	}
+
+	// scale
+	// column : ramp
+	// value : -1
+	for (auto& v : c_ramp) {v = static_cast<float>(v * -1.0);}
+
+	{
+		// sort
+		// column : ramp
+		using Key = std::uint32_t;
+		constexpr auto sign = Key {1} << (sizeof(Key) * 8 - 1);
+		std::vector<Key> keys(c_ramp.size()), tmp(c_ramp.size());
+		for (auto i = std::size_t {0}; i < keys.size(); ++i) {
+			Key k;
+			std::memcpy(&k, &c_ramp[i], sizeof(k));
+			keys[i] = k & sign ? ~k : k | sign;
+		}
+		for (auto shift = 0u; shift < sizeof(Key) * 8; shift += 8) {
+			std::size_t count[257] = {};
+			for (const auto k : keys) {++count[((k >> shift) & 255) + 1];}
+			for (auto d = 0; d < 256; ++d) {count[d + 1] += count[d];}
+			for (const auto k : keys) {tmp[count[(k >> shift) & 255]++] = k;}
+			keys.swap(tmp);
+		}
+		for (auto i = std::size_t {0}; i < keys.size(); ++i) {
+			const Key k = keys[i] & sign ? keys[i] & ~sign : ~keys[i];
+			std::memcpy(&c_ramp[i], &k, sizeof(k));
+		}
+	}
+
+	{
+		// scan
+		// column : ramp
+		auto acc = 0.0;
+		for (auto& v : c_ramp) {acc += v; v = static_cast<float>(acc);}
+	}
+
+	{
+		// histogram
+		// bins : 4
+		// column : ramp
+		const auto n = c_ramp.size();
+		auto lo = std::numeric_limits<double>::infinity(), hi = -lo;
+		for (auto i = std::size_t {0}; i < n; ++i) {
+			const auto x = static_cast<double>(c_ramp[i]);
+			lo = x < lo ? x : lo;
+			hi = x > hi ? x : hi;
+		}
+		const auto bins = std::int64_t {4};
+		const auto scale = hi > lo ? static_cast<double>(bins) / (hi - lo) : 0.0;
+		std::vector<std::int64_t> count(bins + 1, 0);
+		for (auto i = std::size_t {0}; i < n; ++i) {
+			const auto x = static_cast<double>(c_ramp[i]);
+			++count[x >= lo && x <= hi ? std::min(static_cast<std::int64_t>((x - lo) * scale), bins - 1) : bins];
+		}
+		c_ramp_histogram.resize(bins);
+		for (auto b = std::int64_t {0}; b < bins; ++b) {c_ramp_histogram[b] = static_cast<std::int64_t>(count[b]);}
+	}
+
+	// print_data
+	// column : ramp_histogram
+	std::cout << "Data :\n";
+	for (const auto& v : c_ramp_histogram)
+		std::cout << v << "\n";
+
+	// sum
+	// column : ramp
+	// result : ramp_total
+	r_ramp_total = 0.0;
+	for (const auto&v:c_ramp) {r_ramp_total += v;}
 
 	// print
-	std::cout << "Result: " << res <<"\n";
+	// result : ramp_total
+	std::cout << "Result: " << r_ramp_total <<"\n";
 
-	// cleanup
-	data.clear();
-	data.shrink_to_fit();
+	_cleanup();
 
 	return 0;
 }
@@ -1,87 +1,391 @@
 #pragma once
 #include<vector>
 #include<iostream>
+#include<limits>
+#include<cstdint>
+#include<cstring>
+#include<algorithm>
 
-inline void hello_world(std::vector<float>&data, float&res)
+struct RecipeState {
+	std::vector<float> c_data;
+	std::vector<double> c_prices;
+	std::vector<float> c_ramp;
+	std::vector<std::int64_t> c_ramp_histogram;
+	std::vector<float> c_signal;
+	double r_prices_max = 0.0;
+	double r_prices_mean = 0.0;
+	double r_prices_variance = 0.0;
+	double r_ramp_total = 0.0;
+	double r_res = 0.0;
+	double r_signal_sum = 0.0;
+	double r_total = 0.0;
+
+	void hello_world();
+	void print_number_1();
+	void set_values_2();
+	void set_values_3();
+	bool check_data();
+	void sum();
+	void print();
+	bool check_7();
+	void reset();
+	void set_values_9();
+	void print_data();
+	void product();
+	void set_values_14();
+	void sum_15();
+	void print_16();
+	void reduce_17();
+	void print_18();
+	void print_19();
+	void print_20();
+	void set_values_21();
+	void scale_22();
+	void offset_23();
+	void reduce_24();
+	void print_25();
+	void set_values_26();
+	void scale_27();
+	void sort_28();
+	void scan_29();
+	void histogram_30();
+	void print_data_31();
+	void sum_32();
+	void print_33();
+	void _cleanup();
+	bool run_part_0();
+};
+
+inline void RecipeState::hello_world()
 {
 	std::cout << "Hello World !\n";
 }
 
-inline void print_number_1(std::vector<float>&data, float&res)
+inline void RecipeState::print_number_1()
 {
 	// num : 42
-	std::cout<<"Number: "<<42.000000<<"\n";
+	std::cout<<"Number: "<<42.0<<"\n";
 }
 
-inline void set_values_2(std::vector<float>&data, float&res)
+inline void RecipeState::set_values_2()
 {
 	// cnt : 0
-	data.clear();
+	c_data.clear();
 }
 
-inline void set_values_3(std::vector<float>&data, float&res)
+inline void RecipeState::set_values_3()
 {
 	// cnt : 10
-	const auto cnt = 10;
-	data.resize(cnt);
-	for (auto i = 0; i < cnt; ++i) {data[i] = static_cast<float>(i);}
+	const auto cnt = 10LL;
+	c_data.resize(cnt);
+	for (auto i = 0LL; i < cnt; ++i) {c_data[i] = static_cast<float>(i);}
 }
 
-inline auto check_data(std::vector<float>&data, float&res)
+inline bool RecipeState::check_data()
 {
-	const auto populated = !data.empty();
+	const auto populated = !c_data.empty();
 	return populated;
 }
 
-inline void sum(std::vector<float>&data, float&res)
+inline void RecipeState::sum()
 {
-	res = 0.0f;
-	for (const auto&v:data) {res += v;}
+	r_res = 0.0;
+	for (const auto&v:c_data) {r_res += v;}
 }
 
-inline void print(std::vector<float>&data, float&res)
+inline void RecipeState::print()
 {
-	std::cout << "Result: " << res <<"\n";
+	std::cout << "Result: " << r_res <<"\n";
 }
 
-inline auto check_7(std::vector<float>&data, float&res)
+inline bool RecipeState::check_7()
 {
 	// ref : 45
-	const auto expected_value = 45.000000f;
-	const auto res_ok = expected_value == res;
+	const auto expected_value = 45.0;
+	const auto res_ok = expected_value == r_res;
 	return res_ok;
 }
 
-inline void reset(std::vector<float>&data, float&res)
+inline void RecipeState::reset()
 {
-	data.clear();
-	res = 0.0f;
+	c_data.clear();
+	r_res = 0.0;
 }
 
-inline void set_values_9(std::vector<float>&data, float&res)
+inline void RecipeState::set_values_9()
 {
 	// cnt : 20
-	const auto cnt = 20;
-	data.resize(cnt);
-	for (auto i = 0; i < cnt; ++i) {data[i] = static_cast<float>(i);}
+	const auto cnt = 20LL;
+	c_data.resize(cnt);
+	for (auto i = 0LL; i < cnt; ++i) {c_data[i] = static_cast<float>(i);}
 }
 
-inline void print_data(std::vector<float>&data, float&res)
+inline void RecipeState::print_data()
 {
 	std::cout << "Data :\n";
-	for (const auto& v : data)
+	for (const auto& v : c_data)
 		std::cout << v << "\n";
 }
 
-inline void product(std::vector<float>&data, float&res)
+inline void RecipeState::product()
+{
+	r_res = 1.0;
+	for (const auto&v:c_data) {r_res *= v;}
+}
+
+inline void RecipeState::set_values_14()
+{
+	// cnt : 5
+	// column : prices
+	// type : f64
+	const auto cnt = 5LL;
+	c_prices.resize(cnt);
+	for (auto i = 0LL; i < cnt; ++i) {c_prices[i] = static_cast<double>(i);}
+}
+
+inline void RecipeState::sum_15()
+{
+	// column : prices
+	// result : total
+	r_total = 0.0;
+	for (const auto&v:c_prices) {r_total += v;}
+}
+
+inline void RecipeState::print_16()
+{
+	// result : total
+	std::cout << "Result: " << r_total <<"\n";
+}
+
+inline void RecipeState::reduce_17()
+{
+	// column : prices
+	// max : 1
+	// mean : 1
+	// variance : 1
+	const auto n = c_prices.size();
+	auto sum = 0.0;
+	auto lo = std::numeric_limits<double>::infinity(), hi = -lo;
+	auto dev = 0.0, sq = 0.0;
+	const auto shift = 0 < n ? static_cast<double>(c_prices[0]) : 0.0;
+	for (auto i = std::size_t {0}; i < n; ++i) {
+		const auto x = static_cast<double>(c_prices[i]);
+		sum += x;
+		lo = x < lo ? x : lo;
+		hi = x > hi ? x : hi;
+		const auto d = x - shift;
+		dev += d;
+		sq += d * d;
+	}
+	r_prices_max = hi;
+	r_prices_mean = n > 0 ? sum / n : 0.0;
+	r_prices_variance = n > 0 ? (sq - dev * dev / n) / n : 0.0;
+}
+
+inline void RecipeState::print_18()
+{
+	// result : prices_mean
+	std::cout << "Result: " << r_prices_mean <<"\n";
+}
+
+inline void RecipeState::print_19()
+{
+	// result : prices_variance
+	std::cout << "Result: " << r_prices_variance <<"\n";
+}
+
+inline void RecipeState::print_20()
+{
+	// result : prices_max
+	std::cout << "Result: " << r_prices_max <<"\n";
+}
+
+inline void RecipeState::set_values_21()
+{
+	// cnt : 1000
+	// column : signal
+	const auto cnt = 1000LL;
+	c_signal.resize(cnt);
+	for (auto i = 0LL; i < cnt; ++i) {c_signal[i] = static_cast<float>(i);}
+}
+
+inline void RecipeState::scale_22()
+{
+	// column : signal
+	// value : 0.5
+	for (auto& v : c_signal) {v = static_cast<float>(v * 0.5);}
+}
+
+inline void RecipeState::offset_23()
+{
+	// column : signal
+	// value : 1
+	for (auto& v : c_signal) {v = static_cast<float>(v + 1.0);}
+}
+
+inline void RecipeState::reduce_24()
+{
+	// column : signal
+	// sum : 1
+	const auto n = c_signal.size();
+	auto sum = 0.0;
+	for (auto i = std::size_t {0}; i < n; ++i) {
+		const auto x = static_cast<double>(c_signal[i]);
+		sum += x;
+	}
+	r_signal_sum = sum;
+}
+
+inline void RecipeState::print_25()
+{
+	// result : signal_sum
+	std::cout << "Result: " << r_signal_sum <<"\n";
+}
+
+inline void RecipeState::set_values_26()
+{
+	// cnt : 8
+	// column : ramp
+	const auto cnt = 8LL;
+	c_ramp.resize(cnt);
+	for (auto i = 0LL; i < cnt; ++i) {c_ramp[i] = static_cast<float>(i);}
+}
+
+inline void RecipeState::scale_27()
+{
+	// column : ramp
+	// value : -1
+	for (auto& v : c_ramp) {v = static_cast<float>(v * -1.0);}
+}
+
+inline void RecipeState::sort_28()
+{
+	// column : ramp
+	using Key = std::uint32_t;
+	constexpr auto sign = Key {1} << (sizeof(Key) * 8 - 1);
+	std::vector<Key> keys(c_ramp.size()), tmp(c_ramp.size());
+	for (auto i = std::size_t {0}; i < keys.size(); ++i) {
+		Key k;
+		std::memcpy(&k, &c_ramp[i], sizeof(k));
+		keys[i] = k & sign ? ~k : k | sign;
+	}
+	for (auto shift = 0u; shift < sizeof(Key) * 8; shift += 8) {
+		std::size_t count[257] = {};
+		for (const auto k : keys) {++count[((k >> shift) & 255) + 1];}
+		for (auto d = 0; d < 256; ++d) {count[d + 1] += count[d];}
+		for (const auto k : keys) {tmp[count[(k >> shift) & 255]++] = k;}
+		keys.swap(tmp);
+	}
+	for (auto i = std::size_t {0}; i < keys.size(); ++i) {
+		const Key k = keys[i] & sign ? keys[i] & ~sign : ~keys[i];
+		std::memcpy(&c_ramp[i], &k, sizeof(k));
+	}
+}
+
+inline void RecipeState::scan_29()
+{
+	// column : ramp
+	auto acc = 0.0;
+	for (auto& v : c_ramp) {acc += v; v = static_cast<float>(acc);}
+}
+
+inline void RecipeState::histogram_30()
+{
+	// bins : 4
+	// column : ramp
+	const auto n = c_ramp.size();
+	auto lo = std::numeric_limits<double>::infinity(), hi = -lo;
+	for (auto i = std::size_t {0}; i < n; ++i) {
+		const auto x = static_cast<double>(c_ramp[i]);
+		lo = x < lo ? x : lo;
+		hi = x > hi ? x : hi;
+	}
+	const auto bins = std::int64_t {4};
+	const auto scale = hi > lo ? static_cast<double>(bins) / (hi - lo) : 0.0;
+	std::vector<std::int64_t> count(bins + 1, 0);
+	for (auto i = std::size_t {0}; i < n; ++i) {
+		const auto x = static_cast<double>(c_ramp[i]);
+		++count[x >= lo && x <= hi ? std::min(static_cast<std::int64_t>((x - lo) * scale), bins - 1) : bins];
+	}
+	c_ramp_histogram.resize(bins);
+	for (auto b = std::int64_t {0}; b < bins; ++b) {c_ramp_histogram[b] = static_cast<std::int64_t>(count[b]);}
+}
+
+inline void RecipeState::print_data_31()
+{
+	// column : ramp_histogram
+	std::cout << "Data :\n";
+	for (const auto& v : c_ramp_histogram)
+		std::cout << v << "\n";
+}
+
+inline void RecipeState::sum_32()
+{
+	// column : ramp
+	// result : ramp_total
+	r_ramp_total = 0.0;
+	for (const auto&v:c_ramp) {r_ramp_total += v;}
+}
+
+inline void RecipeState::print_33()
+{
+	// result : ramp_total
+	std::cout << "Result: " << r_ramp_total <<"\n";
+}
+
+inline void RecipeState::_cleanup()
 {
-	res = 1.0f;
-	for (const auto&v:data) {res *= v;}
+	c_data.clear();
+	c_data.shrink_to_fit();
+	c_prices.clear();
+	c_prices.shrink_to_fit();
+	c_ramp.clear();
+	c_ramp.shrink_to_fit();
+	c_ramp_histogram.clear();
+	c_ramp_histogram.shrink_to_fit();
+	c_signal.clear();
+	c_signal.shrink_to_fit();
 }
 
-inline void _cleanup(std::vector<float>&data, float&res)
+inline bool RecipeState::run_part_0()
 {
-	data.clear();
-	data.shrink_to_fit();
+	hello_world();
+	print_number_1();
+	set_values_2();
+	set_values_3();
+	if (!check_data())
+		return false;
+	sum();
+	print();
+	if (!check_7())
+		return false;
+	reset();
+	set_values_9();
+	if (!check_data())
+		return false;
+	print_data();
+	product();
+	print();
+	set_values_14();
+	sum_15();
+	print_16();
+	reduce_17();
+	print_18();
+	print_19();
+	print_20();
+	set_values_21();
+	scale_22();
+	offset_23();
+	reduce_24();
+	print_25();
+	set_values_26();
+	scale_27();
+	sort_28();
+	scan_29();
+	histogram_30();
+	print_data_31();
+	sum_32();
+	print_33();
+	return true;
 }
 
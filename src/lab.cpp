@@ -1,17 +1,57 @@
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cassert>
+#include <cctype>
+#include <charconv>
 #include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <numeric>
 #include <optional>
+#include <random>
+#include <ranges>
 #include <set>
+#include <span>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <time.h>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
 #include <vector>
 
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
 class Model;
 struct CodeInfo;
 struct StepInfo;
@@ -19,6 +59,8 @@ struct StepInfo;
 static constexpr const char* NL  = "\n";
 static constexpr const char* TAB = "\t";
 
+#define KEY(key) constexpr static const char* key = #key;
+
 // utility for Conf
 struct check_c_char {
     auto operator()(char const* a, char const* b) const {
@@ -26,15 +68,163 @@ struct check_c_char {
     }
 };
 
-// map to store float values
-struct Conf : public std::map<const char*, float, check_c_char> {
-    // utility to read key from Conf object
+// typed configuration value
+using ConfValue = std::variant<float, double, std::int64_t, std::string>;
+
+// type tags of ConfValue alternatives used in recipe files
+static constexpr const char* conf_type_names[] = {"f32", "f64", "i64", "str"};
+
+// returns the value as text; numbers are formatted like std::ostream does by default
+static std::string conf_string(const ConfValue& value) {
+    return std::visit(
+        [](const auto& v) -> std::string {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, std::string>) {
+                return v;
+            } else if constexpr (std::is_floating_point_v<T>) {
+                char buffer[32];
+                std::snprintf(buffer, sizeof buffer, "%g", static_cast<double>(v));
+                return buffer;
+            } else {
+                return std::to_string(v);
+            }
+        },
+        value);
+}
+
+// returns the value as text that reads back to the exact same value
+static std::string conf_string_exact(const ConfValue& value) {
+    std::ostringstream stream;
+    std::visit(
+        [&](auto v) {
+            stream.precision(std::numeric_limits<decltype(v)>::max_digits10);
+            stream << v;
+        },
+        value);
+    return stream.str();
+}
+
+// returns the value of given type tag parsed from text
+static std::optional<ConfValue> conf_parse(const std::string& type, const std::string& text) {
+    try {
+        if (type == conf_type_names[0])
+            return ConfValue {std::stof(text)};
+        if (type == conf_type_names[1])
+            return ConfValue {std::stod(text)};
+        if (type == conf_type_names[2])
+            return ConfValue {static_cast<std::int64_t>(std::stoll(text))};
+        if (type == conf_type_names[3])
+            return ConfValue {text};
+    } catch (...) {
+    }
+    return std::nullopt;
+}
+
+// returns a pointer to a permanent copy of the given key
+static const char* conf_intern_key(const std::string& key) {
+    static std::set<std::string> keys;
+    return keys.insert(key).first->c_str();
+}
+
+// returns the 64-bit FNV-1a hash of the text; continues the given hash
+static std::uint64_t hash_text(std::string_view text,
+                               std::uint64_t hash = 14695981039346656037ull) {
+    for (const auto c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// map to store typed values
+struct Conf : public std::map<const char*, ConfValue, check_c_char> {
+    // utility to read numeric key from Conf object; returns ref for text values
     template <typename T> auto get_value(const char* id, T ref) const {
         auto v = find(id);
         if (v != end())
-            return static_cast<T>(v->second);
+            return std::visit(
+                [ref](const auto& value) {
+                    if constexpr (std::is_arithmetic_v<std::decay_t<decltype(value)>>)
+                        return static_cast<T>(value);
+                    else
+                        return ref;
+                },
+                v->second);
+        return ref;
+    }
+
+    // utility to read text key from Conf object; returns ref for numeric values
+    std::string get_string(const char* id, const char* ref) const {
+        auto v = find(id);
+        if (v != end() && std::holds_alternative<std::string>(v->second))
+            return std::get<std::string>(v->second);
         return ref;
     }
+
+    // returns the hash of all keys and values
+    std::uint64_t hash() const {
+        auto h = hash_text({});
+        for (const auto& [key, value] : *this) {
+            const auto type = static_cast<char>(value.index());
+            h = hash_text({&type, 1}, hash_text(key, h));
+            std::visit(
+                [&h](const auto& v) {
+                    if constexpr (std::is_same_v<std::decay_t<decltype(v)>, std::string>)
+                        h = hash_text(v, h);
+                    else
+                        h = hash_text({reinterpret_cast<const char*>(&v), sizeof(v)}, h);
+                },
+                value);
+        }
+        return h;
+    }
+
+    // returns true if both store the same keys and values; keys are compared as text
+    bool same(const Conf& other) const {
+        return size() == other.size() &&
+               std::equal(begin(), end(), other.begin(), [](const auto& a, const auto& b) {
+                   return std::strcmp(a.first, b.first) == 0 && a.second == b.second;
+               });
+    }
+};
+
+// stores distinct Conf objects once; equal Conf objects share the same index
+class ConfPool {
+public:
+    // index of the empty Conf
+    static constexpr std::uint32_t empty = 0;
+
+    ConfPool() {
+        intern({});
+    }
+
+    // returns the index of the stored Conf equal to the given one; stores it if it is new
+    std::uint32_t intern(Conf&& conf) {
+        auto& candidates = _by_hash[conf.hash()];
+        for (const auto index : candidates)
+            if (_configs[index].same(conf))
+                return index;
+
+        const auto index = static_cast<std::uint32_t>(_configs.size());
+        _configs.push_back(std::move(conf));
+        candidates.push_back(index);
+        return index;
+    }
+
+    // returns the Conf of the given index
+    const Conf& get(std::uint32_t index) const {
+        return _configs[index];
+    }
+
+    // returns the number of distinct Conf objects
+    auto count() const {
+        return static_cast<unsigned int>(_configs.size());
+    }
+
+private:
+    // a deque, so the references returned by get() stay valid when new Conf objects are stored
+    std::deque<Conf>                                              _configs;
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> _by_hash;
 };
 
 // list of source code lines
@@ -101,7 +291,7 @@ private:
     std::vector<RecipeStep> _steps;
 };
 
-// instance of a RecipeStep; storing additional Conf object
+// instance of a RecipeStep; refers to the Conf object stored in the Recipe
 struct RecipeStepInstance {
     // executes the step
     auto execute(Model& m) const {
@@ -113,482 +303,3621 @@ struct RecipeStepInstance {
         _step->_code(_config, code, info);
     }
 
-    // stores a key in the Conf member
-    void set_config(const char* id, float v) {
-        _config[id] = v;
+    const RecipeStep* const _step;
+    const Conf&             _config;
+};
+
+class Recipe;
+
+// access to a step stored in a Recipe and its Conf at the time of the access
+struct RecipeStepAccess {
+    const RecipeStepAccess* operator->() const {
+        return this;
     }
 
+    // stores a key in the Conf of the step
+    void set_config(const char* id, ConfValue v) const;
+
     const RecipeStep* const _step;
-    Conf _config;
+    const Conf&             _config;
+    Recipe&                 _recipe;
+    const unsigned int      _index;
+};
+
+// reference to a step stored in a Recipe; used to configure the step
+// ref->_step, ref->_config and ref->set_config(..) work as on a RecipeStepInstance pointer
+class RecipeStepRef {
+public:
+    RecipeStepRef(Recipe& recipe, unsigned int index) : _recipe {recipe}, _index {index} {}
+
+    RecipeStepAccess operator->() const;
+
+    // stores a key in the Conf of the step
+    void set_config(const char* id, ConfValue v);
+
+private:
+    Recipe&            _recipe;
+    const unsigned int _index;
 };
 
-// recipe stores list of RecipeStepInstance objects
+// recipe stores a list of steps; per step only a step index and a Conf index are kept
+// in contiguous arrays, so recipes of millions of steps with few distinct configurations
+// use a few bytes per step
 class Recipe {
 public:
-    Recipe() {
-        _steps.reserve(64);
-    }
+    Recipe()  = default;
     ~Recipe() = default;
 
-    // adds a new RecipeStepInstance based on the given RecipeStep
+    // adds a new step instance based on the given RecipeStep
     auto add_step(const RecipeStep* step) {
-        _steps.push_back({step, {}});
+        auto id = std::find(_step_table.begin(), _step_table.end(), step) - _step_table.begin();
+        if (id == static_cast<std::ptrdiff_t>(_step_table.size())) {
+            assert(_step_table.size() < std::numeric_limits<std::uint16_t>::max());
+            _step_table.push_back(step);
+        }
+        _step_ids.push_back(static_cast<std::uint16_t>(id));
+        _conf_ids.push_back(ConfPool::empty);
         return count() - 1u;
     }
 
     // returns number of stored steps
     unsigned int count() const {
-        return static_cast<unsigned int>(_steps.size());
+        return static_cast<unsigned int>(_step_ids.size());
     }
 
-    // returns RecipeStepInstance at the given index
-    std::optional<RecipeStepInstance* const> get(unsigned int index) {
-        if (index < _steps.size())
-            return &_steps[index];
+    // returns a reference to the step at the given index
+    std::optional<RecipeStepRef> get(unsigned int index) {
+        if (index < count())
+            return RecipeStepRef {*this, index};
         return std::nullopt;
     }
 
-    // returns reference to list of step instances
-    const std::vector<RecipeStepInstance>& all() const {   
-        return _steps;
+    // returns a random access range of all step instances
+    auto all() const {
+        return std::views::iota(0u, count()) |
+               std::views::transform([this](unsigned int i) { return instance(i); });
+    }
+
+    // returns the step instance at the given index
+    RecipeStepInstance instance(unsigned int index) const {
+        return {_step_table[_step_ids[index]], _configs.get(_conf_ids[index])};
+    }
+
+    // stores a key in the Conf of the step at the given index
+    // the changed Conf is interned; Conf objects left unused stay in the pool
+    void set_config(unsigned int index, const char* id, ConfValue v) {
+        auto conf = _configs.get(_conf_ids[index]);
+        conf[id]  = std::move(v);
+        _conf_ids[index] = _configs.intern(std::move(conf));
+    }
+
+    // returns the number of distinct Conf objects
+    auto conf_count() const {
+        return _configs.count();
     }
 
     // stores Recipe to text file
     void store(const char* file) {
         std::ofstream file_stream {file, std::ofstream::out};
-        for (const auto& s : _steps) {
+        for (const auto& s : all()) {
             file_stream << s._step->_name << NL;
             if (!s._config.empty()) {
                 for (const auto& [key, value] : s._config)
-                    file_stream << "-->" << key << ":" << std::to_string(value) << NL;
+                    file_stream << "-->" << key << ":" << conf_type_names[value.index()] << ":"
+                                << conf_string_exact(value) << NL;
+            }
+        }
+    }
+
+    // loads Recipe from text file; keys without type tag are read as float
+    // returns false if the file can't be read or contains unknown steps
+    bool load(const char* file, const Registry& reg) {
+        std::ifstream file_stream {file, std::ifstream::in};
+        if (!file_stream)
+            return false;
+
+        _step_table.clear();
+        _step_ids.clear();
+        _conf_ids.clear();
+        _configs = {};
+
+        std::string line;
+        while (std::getline(file_stream, line)) {
+            if (line.empty())
+                continue;
+
+            if (line.starts_with("-->")) {
+                if (count() == 0)
+                    return false;
+
+                const auto a = line.find(':');
+                const auto b = line.find(':', a + 1);
+                if (a == std::string::npos)
+                    return false;
+
+                const auto key   = line.substr(3, a - 3);
+                const auto value =
+                    b == std::string::npos
+                        ? conf_parse(conf_type_names[0], line.substr(a + 1))
+                        : conf_parse(line.substr(a + 1, b - a - 1), line.substr(b + 1));
+                if (!value)
+                    return false;
+
+                set_config(count() - 1, conf_intern_key(key), value.value());
+                continue;
             }
+
+            const auto step = reg.get_step(line.c_str());
+            if (!step)
+                return false;
+            add_step(step.value());
         }
+        return true;
     }
 
 private:
-    std::vector<RecipeStepInstance> _steps;
+    std::vector<const RecipeStep*> _step_table;
+    std::vector<std::uint16_t>     _step_ids;
+    std::vector<std::uint32_t>     _conf_ids;
+    ConfPool                       _configs;
 };
 
+inline void RecipeStepAccess::set_config(const char* id, ConfValue v) const {
+    _recipe.set_config(_index, id, std::move(v));
+}
+
+inline RecipeStepAccess RecipeStepRef::operator->() const {
+    const auto s = _recipe.instance(_index);
+    return {s._step, s._config, _recipe, _index};
+}
+
+inline void RecipeStepRef::set_config(const char* id, ConfValue v) {
+    _recipe.set_config(_index, id, std::move(v));
+}
+
 // ---------------------------- Data Model ----------------------------
 
-// data mode; modified by RecipeStep objects
-class Model {
-public:
-    Model() {};
-    ~Model() {};
+// alignment of Model data; a cache line and the widest SIMD register
+static constexpr std::size_t data_alignment = 64;
 
-    std::vector<float> _data;
-    float _res = 0.0f;
+// frees memory of aligned_allocate or mapped_allocate; memory owned by someone else is left alone
+struct AlignedFree {
+    bool _owned = true;
+    // size of memory from mapped_allocate
+    std::size_t _mapped = 0;
 
-    static void setup_code(CodeLines& code) {
-        code.push_back("std::vector<float> data;");
-        code.push_back("auto res = .0f;");
-    }
-    static void cleanup_code(CodeLines& code) {
-        code.push_back("data.clear();");
-        code.push_back("data.shrink_to_fit();");
+    void operator()(void* p) const {
+        if (!_owned)
+            return;
+#ifdef __linux__
+        if (_mapped != 0) {
+            ::munmap(p, _mapped);
+            return;
+        }
+#endif
+        ::operator delete(p, std::align_val_t {data_alignment});
     }
 };
 
-// information on the generated code
-struct CodeInfo {
-    bool needs_scope = false;
-};
+// allocates uninitialized memory for count elements aligned to data_alignment
+template <typename T> static auto aligned_allocate(std::int64_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    auto* p = ::operator new(sizeof(T) * count, std::align_val_t {data_alignment});
+    return std::unique_ptr<T[], AlignedFree>(static_cast<T*>(p));
+}
 
-// information on the specific step
-struct StepInfo {
-    bool always_same_code     = false;
-    bool returns_stop         = false;
-    const char* stop_variable = nullptr;
+// placement of Model data on the NUMA nodes of the host; see placement_names
+enum class Placement {
+    // the OS places a page on the node of the thread writing it first
+    first_touch,
+    // pages are spread round-robin over all nodes
+    interleave,
+    // new chunks are written first by the threads of parallel_chunks; each chunk stays on the node
+    // of the thread reducing it later
+    local,
 };
 
-// ---------------------------- cook the recipe ----------------------------
+static constexpr const char* placement_names[] = {"first_touch", "interleave", "local"};
 
-// runs a recipe
-static void run(Recipe& recipe,
-                std::function<void(unsigned int, const char*)> progress,
-                std::function<void(const char*, float)> print_key,
-                std::function<void(long long)> print_time) {
-    Model model;
+// allocation of Model data
+struct MemorySettings {
+    Placement placement = Placement::first_touch;
+    // backs the data with huge pages; MAP_HUGETLB if pages are reserved, else transparent ones
+    bool huge_pages = false;
+};
 
-    auto start = std::chrono::system_clock::time_point {};
+// NUMA nodes with CPUs and the CPUs of each node; a single node if the host doesn't tell
+struct NumaTopology {
+    std::vector<int> _ids;
+    std::vector<std::vector<int>> _cpus;
 
-    auto i = 0;
-    for (const auto& s : recipe.all()) {
-  
-        progress(i, s._step->_name);
+    auto nodes() const {
+        return _cpus.size();
+    }
+};
 
-        for (const auto& [key, v] : s._config)
-            print_key(key, v);
+// returns the numbers of a list like "0-3,8,10-11"
+static std::vector<int> parse_id_list(const std::string& text) {
+    std::vector<int> ids;
+    std::istringstream stream {text};
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        try {
+            const auto dash  = range.find('-');
+            const auto first = std::stoi(range.substr(0, dash));
+            const auto last =
+                dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (auto id = first; id <= last; ++id)
+                ids.push_back(id);
+        } catch (...) {
+        }
+    }
+    return ids;
+}
 
-        start = std::chrono::system_clock::now();
+// returns the NUMA topology of the host; read once
+static const NumaTopology& numa_topology() {
+    static const auto topology = []() {
+        NumaTopology res;
+#ifdef __linux__
+        std::ifstream online {"/sys/devices/system/node/online"};
+        std::string nodes;
+        std::getline(online, nodes);
+        for (const auto node : parse_id_list(nodes)) {
+            const auto path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+            std::ifstream cpu_file {path};
+            std::string cpus;
+            std::getline(cpu_file, cpus);
+            // memory-only nodes run no threads; node masks of mbind are limited to 64 nodes here
+            auto ids = parse_id_list(cpus);
+            if (ids.empty() || node >= 64)
+                continue;
+            res._ids.push_back(node);
+            res._cpus.push_back(std::move(ids));
+        }
+#endif
+        if (res._cpus.empty()) {
+            res._ids  = {0};
+            res._cpus = {{}};
+        }
+        return res;
+    }();
+    return topology;
+}
 
-        if (!s.execute(model))
-            return;
+// binds the calling thread to the CPUs of the given node; does nothing on single-node hosts
+static void bind_thread_to_node(std::size_t node) {
+#ifdef __linux__
+    const auto& topology = numa_topology();
+    if (topology.nodes() <= 1)
+        return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : topology._cpus[node % topology.nodes()])
+        CPU_SET(cpu, &set);
+    ::sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)node;
+#endif
+}
 
-        const auto end = std::chrono::system_clock::now();
-        const auto diff =
-            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+#ifdef __linux__
 
-        print_time(diff);
-        start = end;
+// memory policies of mbind; numaif.h isn't needed for these
+static constexpr int mpol_bind       = 2;
+static constexpr int mpol_interleave = 3;
 
-        ++i;
-    }
+// sets the memory policy of the pages in [p, p + bytes) to the given nodes
+// returns false if the kernel refuses, e.g. in containers without the permission
+static bool bind_memory(void* p, std::size_t bytes, int mode, std::uint64_t nodes) {
+    return ::syscall(SYS_mbind, p, bytes, mode, &nodes, 65, 0) == 0;
 }
 
-// create code from the Recipe
-static void create_code(Recipe& recipe, const char* file) {
-
-    std::ofstream stream {file, std::ofstream::out};
+// returns the mask of all nodes of the topology
+static std::uint64_t all_nodes() {
+    auto mask = std::uint64_t {0};
+    for (const auto id : numa_topology()._ids)
+        mask |= std::uint64_t {1} << id;
+    return mask;
+}
 
-    {
-        const auto now  = std::chrono::system_clock::now();
-        const auto time = std::chrono::system_clock::to_time_t(now);
-        char buffer[26];
-        ctime_s(buffer, sizeof buffer, &time);
-        stream << "// " << buffer << NL;
+// maps memory for count elements placed according to the settings; the pages are not written
+template <typename T>
+static auto mapped_allocate(std::int64_t count, const MemorySettings& memory) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    constexpr auto huge_page = std::size_t {2} << 20;
+
+    auto bytes = sizeof(T) * static_cast<std::size_t>(count);
+    auto* p    = MAP_FAILED;
+    if (memory.huge_pages) {
+        // fails unless huge pages are reserved
+        const auto huge_bytes = (bytes + huge_page - 1) / huge_page * huge_page;
+        p = ::mmap(nullptr, huge_bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+            bytes = huge_bytes;
+    }
+    if (p == MAP_FAILED) {
+        p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc {};
+        if (memory.huge_pages)
+            ::madvise(p, bytes, MADV_HUGEPAGE);
     }
 
-    CodeLines code;
-    code.reserve(64);
+    if (memory.placement == Placement::interleave && numa_topology().nodes() > 1)
+        bind_memory(p, bytes, mpol_interleave, all_nodes());
 
-    stream << "#include<vector>" << NL;
-    stream << "#include<iostream>" << NL << NL;
-    stream << "int main() {" << NL << NL;
+    return std::unique_ptr<T[], AlignedFree>(static_cast<T*>(p), AlignedFree {true, bytes});
+}
 
-    code.clear();
-    Model::setup_code(code);
-    for (const auto& line : code)
-        stream << "\t" << line << "\n";
+#endif
+
+// allocates uninitialized memory for count elements of Model data according to the settings
+template <typename T> static auto data_allocate(std::int64_t count, const MemorySettings& memory) {
+#ifdef __linux__
+    // fresh mappings are placed by their first write; reused heap memory already is placed
+    if (memory.placement != Placement::first_touch || memory.huge_pages)
+        return mapped_allocate<T>(count, memory);
+#else
+    (void)memory;
+#endif
+    return aligned_allocate<T>(count);
+}
 
-    CodeLines cleanup_code;
-    cleanup_code.push_back("// cleanup");
-    Model::cleanup_code(cleanup_code);
+// writes one byte per page, so the OS places the pages on the node of the calling thread
+static void touch_pages(void* p, std::size_t bytes) {
+    constexpr auto page = std::size_t {4096};
+    auto* data          = static_cast<char*>(p);
+    for (auto offset = std::size_t {0}; offset < bytes; offset += page)
+        data[offset] = 0;
+}
 
-    for (const auto& s: recipe.all()) {
-    
-            CodeInfo info;
-            code.clear();
-            s.make_code(code, info);
+// returns the number of threads the process may run at once; all hardware threads unless
+// the process shares the hardware, like the workers of a sharded run
+static std::int64_t& thread_limit() {
+    static auto limit =
+        static_cast<std::int64_t>(std::max(1u, std::thread::hardware_concurrency()));
+    return limit;
+}
 
-            stream << "\n";
-            if (info.needs_scope)
-                stream << "\t{" << NL;
+// calls func(c) for each chunk index c; contiguous ranges of chunks are handled by separate threads
+// max_threads limits the number of threads; 0 uses thread_limit()
+// on NUMA hosts the threads are spread over the nodes in order
+template <typename FUNC>
+static void parallel_chunks(std::int64_t chunks, FUNC&& func, std::int64_t max_threads = 0) {
+    const auto limit   = thread_limit();
+    const auto threads = std::min(chunks, max_threads > 0 ? std::min(max_threads, limit) : limit);
+
+    if (threads <= 1) {
+        for (auto c = std::int64_t {0}; c < chunks; ++c)
+            func(c);
+        return;
+    }
 
-            auto* tabs = "\t";
-            if (info.needs_scope)
-                tabs = "\t\t";
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (auto t = std::int64_t {0}; t < threads; ++t) {
+        pool.emplace_back([&func, chunks, threads, t]() {
+            // every call binds the same chunks to the same node
+            bind_thread_to_node(t * numa_topology().nodes() / threads);
+            const auto end = chunks * (t + 1) / threads;
+            for (auto c = chunks * t / threads; c < end; ++c)
+                func(c);
+        });
+    }
+    for (auto& thread : pool)
+        thread.join();
+}
 
-            stream << tabs << "// " << s._step->_name << NL;
 
-            for (const auto& [key, v] : s._config)
-                stream << tabs << "// " << key << " : " << v << NL;
+// array of 64-bit size stored in separately allocated, aligned chunks
+// growing never moves existing chunks, so multi-GB arrays don't need one contiguous block
+template <typename T> class ChunkedArray {
+public:
+    static constexpr std::int64_t chunk_bits     = 22;
+    static constexpr std::int64_t chunk_elements = std::int64_t {1} << chunk_bits;
 
-            for (const auto& line : code)
-                stream << tabs << line << NL;
+    ChunkedArray()  = default;
+    ~ChunkedArray() = default;
 
-            StepInfo stepInfo;
-            s._step->_info(stepInfo);
-            if (stepInfo.returns_stop) {
-                stream << tabs << "if (!" + std::string {stepInfo.stop_variable} + ") {" << NL;
+    explicit ChunkedArray(const MemorySettings& memory) : _memory(memory) {}
 
-                for (const auto& line : cleanup_code)
-                    stream << tabs << "\t" << line << NL;
+    ChunkedArray(ChunkedArray&&)            = default;
+    ChunkedArray& operator=(ChunkedArray&&) = default;
 
-                stream << tabs << "\treturn 0;" << NL;
-                stream << tabs << "}" << NL;
-            }
+    // returns the number of elements
+    auto size() const {
+        return _size;
+    }
 
-            if (info.needs_scope)
-                stream << "\t}" << NL;
-       
+    // returns true if there are no elements
+    auto empty() const {
+        return _size == 0;
     }
-    {
-        stream << NL;
-        for (const auto& line : cleanup_code)
-            stream << "\t" << line << NL;
+
+    // returns the number of chunks
+    auto chunk_count() const {
+        return static_cast<std::int64_t>(_chunks.size());
     }
 
-    stream << NL << "\treturn 0;" << NL;
-    stream << "}" << NL;
+    // returns the number of elements in the given chunk
+    auto chunk_size(std::int64_t c) const {
+        return std::min(chunk_elements, _size - c * chunk_elements);
+    }
 
-    stream.close();
-}
+    // returns the elements of the given chunk
+    T* chunk(std::int64_t c) {
+        return _chunks[c]._data.get();
+    }
+    const T* chunk(std::int64_t c) const {
+        return _chunks[c]._data.get();
+    }
 
-// create code from the Recipe
-static void create_code_func(Recipe& recipe, const char* cpp_file, const char* header_file) {
-    const auto cnt = recipe.count();
+    T& operator[](std::int64_t i) {
+        return _chunks[i >> chunk_bits]._data[i & (chunk_elements - 1)];
+    }
+    const T& operator[](std::int64_t i) const {
+        return _chunks[i >> chunk_bits]._data[i & (chunk_elements - 1)];
+    }
 
-    auto func_name = [](const RecipeStep* step, const StepInfo& info, unsigned int i) {
-        if (info.always_same_code)
-            return std::string(step->_name);
+    // calls func(values, n) for consecutive pieces of the elements first to last;
+    // every piece lies in one chunk
+    template <typename FUNC> void pieces(std::int64_t first, std::int64_t last, FUNC&& func) {
+        while (first < last) {
+            const auto c   = first >> chunk_bits;
+            const auto end = std::min(last, (c + 1) << chunk_bits);
+            func(chunk(c) + (first & (chunk_elements - 1)), end - first);
+            first = end;
+        }
+    }
+    template <typename FUNC> void pieces(std::int64_t first, std::int64_t last, FUNC&& func) const {
+        while (first < last) {
+            const auto c   = first >> chunk_bits;
+            const auto end = std::min(last, (c + 1) << chunk_bits);
+            func(chunk(c) + (first & (chunk_elements - 1)), end - first);
+            first = end;
+        }
+    }
 
-        return std::string(step->_name) + "_" + std::to_string(i);
-    };
+    // copies n values to the elements starting at first
+    void write(std::int64_t first, const T* values, std::int64_t n) {
+        pieces(first, first + n, [&values](T* target, std::int64_t size) {
+            std::copy_n(values, size, target);
+            values += size;
+        });
+    }
 
-    {
-        std::ofstream header_stream {header_file, std::ofstream::out};
+    // changes the number of elements; new elements are not initialized
+    void resize(std::int64_t size) {
+        const auto chunks = (size + chunk_elements - 1) / chunk_elements;
+        _chunks.resize(chunks);
+        _size = size;
+
+        // chunks whose pages are placed by the first write
+        std::vector<char> fresh(chunks, 0);
+
+        for (auto c = std::int64_t {0}; c < chunks; ++c) {
+            auto& chunk = _chunks[c];
+            const auto needed = chunk_size(c);
+            if (chunk._capacity >= needed)
+                continue;
+
+            // only the last chunk is allocated smaller than chunk_elements
+            const auto capacity = c + 1 < chunks ? chunk_elements : needed;
+            auto data           = data_allocate<T>(capacity, _memory);
+            if (chunk._data)
+                std::copy_n(chunk._data.get(), chunk._capacity, data.get());
+            else
+                fresh[c] = 1;
+            chunk._data     = std::move(data);
+            chunk._capacity = capacity;
+        }
+
+        // the chunks are written first with the partitioning of the steps reading them
+        if (_memory.placement == Placement::local && numa_topology().nodes() > 1)
+            parallel_chunks(chunks, [this, &fresh](std::int64_t c) {
+                if (fresh[c])
+                    touch_pages(_chunks[c]._data.get(), sizeof(T) * _chunks[c]._capacity);
+            });
+    }
 
-        header_stream << "#pragma once" << NL;
-        header_stream << "#include<vector>" << NL;
-        header_stream << "#include<iostream>" << NL << NL;
+    // removes all elements and frees the memory
+    void clear() {
+        _chunks.clear();
+        _size = 0;
+    }
 
-        std::set<std::string> func_names;
+    // uses the given memory of size elements instead of allocating chunks; the memory is not freed
+    // and must outlive the array; data must be aligned to data_alignment
+    void attach(T* data, std::int64_t size) {
+        clear();
+        _size = size;
+        for (auto c = std::int64_t {0}; c * chunk_elements < size; ++c)
+            _chunks.push_back(
+                {std::unique_ptr<T[], AlignedFree>(data + c * chunk_elements, AlignedFree {false}),
+                 chunk_size(c)});
+    }
 
-        for (auto i = 0u; i < cnt; ++i) {
-            auto step = recipe.get(i);
-            if (step) {
-                const auto* s = step.value();
+private:
+    struct Chunk {
+        std::unique_ptr<T[], AlignedFree> _data;
+        std::int64_t _capacity = 0;
+    };
 
-                StepInfo stepInfo;
-                s->_step->_info(stepInfo);
+    std::vector<Chunk> _chunks;
+    std::int64_t _size = 0;
+    MemorySettings _memory;
+};
 
-                const auto function_name = func_name(s->_step, stepInfo, i);
+// column of the Model; elements of one type in structure-of-arrays layout
+using Column = std::variant<ChunkedArray<float>,
+                            ChunkedArray<double>,
+                            ChunkedArray<std::int32_t>,
+                            ChunkedArray<std::int64_t>>;
 
-                if (!func_names.contains(function_name)) {
-                    std::string returnValue = "void";
-                    if (stepInfo.returns_stop)
-                        returnValue = "auto";
+// type tags of Column alternatives used in Conf
+static constexpr const char* column_type_names[] = {"f32", "f64", "i32", "i64"};
 
-                    const auto func_declaration = "inline " + returnValue + " " + function_name +
-                                                  "(std::vector<float>&data, float&res)" + NL;
+// element types of Column alternatives used in generated code
+static constexpr const char* column_code_types[] = {
+    "float", "double", "std::int32_t", "std::int64_t"};
 
-                    header_stream << func_declaration;
-                    header_stream << "{" << NL;
+// element sizes of Column alternatives in bytes
+static constexpr std::size_t column_sizes[] = {
+    sizeof(float), sizeof(double), sizeof(std::int32_t), sizeof(std::int64_t)};
 
-                    for (const auto& [key, v] : s->_config)
-                        header_stream << "\t// " << key << " : " << v << NL;
+// returns the index of the column type with the given tag; float if unknown
+static std::size_t column_type(const std::string& tag) {
+    for (auto t = 0u; t < std::size(column_type_names); ++t)
+        if (tag == column_type_names[t])
+            return t;
+    return 0;
+}
 
-                    CodeLines code;
-                    CodeInfo info;
-                    s->make_code(code, info);
-                    for (const auto& line : code)
-                        header_stream << "\t" << line << NL;
+// returns an empty column of the given type index
+static Column make_column(std::size_t type, const MemorySettings& memory = {}) {
+    switch (type) {
+    case 1:
+        return ChunkedArray<double> {memory};
+    case 2:
+        return ChunkedArray<std::int32_t> {memory};
+    case 3:
+        return ChunkedArray<std::int64_t> {memory};
+    default:
+        return ChunkedArray<float> {memory};
+    }
+}
 
-                    if (stepInfo.returns_stop && stepInfo.stop_variable)
-                        header_stream << "\treturn " << stepInfo.stop_variable << ";" << NL;
+namespace conf {
+    // keys selecting the columns and results used by a step
+    namespace model {
+        KEY(column)
+        KEY(result)
+        KEY(type)
+    }
+} // namespace conf
 
-                    header_stream << "}" << NL << NL;
+// element-wise operation recorded instead of being applied to memory
+struct LazyOp {
+    // '*' or '+'
+    char _op      = '*';
+    double _value = 1.0;
+};
 
-                    func_names.insert(function_name);
-                }
+// column whose elements are computed when read; element i is static_cast<T>(i)
+// followed by the recorded operations, each rounded to the element type like the eager steps
+struct LazyColumn {
+    // elements computed per block; the block stays in L1 cache while all operations are applied
+    static constexpr std::int64_t block_elements = 4096;
+
+    std::size_t _type  = 0;
+    std::int64_t _size = 0;
+    std::vector<LazyOp> _ops;
+
+    // computes the elements [first, first + n) into out
+    template <typename T> void evaluate(std::int64_t first, std::int64_t n, T* out) const {
+        for (auto b = std::int64_t {0}; b < n; b += block_elements) {
+            auto* block      = out + b;
+            const auto count = std::min(block_elements, n - b);
+            for (auto i = std::int64_t {0}; i < count; ++i)
+                block[i] = static_cast<T>(first + b + i);
+            for (const auto& op : _ops) {
+                const auto value = op._value;
+                if (op._op == '*')
+                    for (auto i = std::int64_t {0}; i < count; ++i)
+                        block[i] = static_cast<T>(block[i] * value);
+                else
+                    for (auto i = std::int64_t {0}; i < count; ++i)
+                        block[i] = static_cast<T>(block[i] + value);
             }
         }
-        {
-            CodeLines code;
-            Model::cleanup_code(code);
+    }
+};
 
-            header_stream << "inline void _cleanup(std::vector<float>&data, float&res)" << NL;
-            header_stream << "{" << NL;
+// read access to a column that is either stored or lazy
+// chunks are the same in both cases, so reductions combine partial results in the same order
+template <typename T> class ColumnView {
+public:
+    static constexpr auto chunk_elements = ChunkedArray<T>::chunk_elements;
 
-            for (const auto& line : code)
-                header_stream << "\t" << line << NL;
+    explicit ColumnView(const ChunkedArray<T>& data) : _data(&data) {}
+    explicit ColumnView(const LazyColumn& lazy) : _lazy(&lazy) {}
 
-            header_stream << "}" << NL << NL;
-        }
-        header_stream.close();
+    std::int64_t size() const {
+        return _data ? _data->size() : _lazy->_size;
     }
-    {
-        std::ofstream cpp_stream {cpp_file, std::ofstream::out};
 
-        cpp_stream << "#include \"" << header_file << "\"" << NL << NL;
-        cpp_stream << "int main() {" << NL << NL;
-
-        {
-            CodeLines code;
-            Model::setup_code(code);
-            for (const auto& line : code)
-                cpp_stream << "\t" << line << NL;
-        }
+    std::int64_t chunk_count() const {
+        return (size() + chunk_elements - 1) / chunk_elements;
+    }
 
-        for (auto i = 0u; i < cnt; ++i) {
-            auto step = recipe.get(i);
-            if (step) {
-                const auto* s = step.value();
+    std::int64_t chunk_size(std::int64_t c) const {
+        return std::min(chunk_elements, size() - c * chunk_elements);
+    }
 
-                StepInfo info;
-                s->_step->_info(info);
+    // calls func(values, n) for consecutive blocks of the given chunk
+    // stored chunks are passed as one block; lazy chunks are computed block by block
+    template <typename FUNC> void blocks(std::int64_t c, FUNC&& func) const {
+        range(c * chunk_elements, c * chunk_elements + chunk_size(c), func);
+    }
 
-                const auto fname = func_name(s->_step, info, i) + "(data, res)";
+    // calls func(values, n) for consecutive blocks of the elements first to last
+    // stored elements are passed as one block per chunk; lazy elements are computed block by block
+    template <typename FUNC> void range(std::int64_t first, std::int64_t last, FUNC&& func) const {
+        if (_data) {
+            _data->pieces(first, last, func);
+            return;
+        }
 
-                if (info.returns_stop) {
-                    cpp_stream << "\n\tif (!" << fname << ") {" << NL;
-                    cpp_stream << "\t\t_cleanup(data, res);" << NL;
-                    cpp_stream << "\t\treturn 0;" << NL;
-                    cpp_stream << "\t}" << NL;
-                } else {
-                    cpp_stream << NL;
-                    cpp_stream << "\t" << fname << ";" << NL;
-                }
-            }
+        alignas(data_alignment) T buffer[LazyColumn::block_elements];
+        for (auto b = first; b < last; b += LazyColumn::block_elements) {
+            const auto n = std::min(LazyColumn::block_elements, last - b);
+            _lazy->evaluate(b, n, buffer);
+            func(static_cast<const T*>(buffer), n);
         }
+    }
+
+private:
+    const ChunkedArray<T>* _data = nullptr;
+    const LazyColumn* _lazy      = nullptr;
+};
 
-        cpp_stream << NL << "\t_cleanup(data, res);" << NL;
+// calls func(ColumnView<T>) with the element type of the given type index
+template <typename FUNC> static void visit_lazy(const LazyColumn& lazy, FUNC&& func) {
+    switch (lazy._type) {
+    case 1:
+        return func(ColumnView<double> {lazy});
+    case 2:
+        return func(ColumnView<std::int32_t> {lazy});
+    case 3:
+        return func(ColumnView<std::int64_t> {lazy});
+    default:
+        return func(ColumnView<float> {lazy});
+    }
+}
 
-        cpp_stream << NL << "\treturn 0;" << NL;
-        cpp_stream << "}" << NL;
+// returns text of a double literal that reads back to the same value
+static std::string double_literal(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof buffer, "%.17g", value);
+    std::string res = buffer;
+    if (res.find_first_of(".en") == std::string::npos)
+        res += ".0";
+    return res;
+}
 
-        cpp_stream.close();
+// returns text of a string literal of the given text
+static std::string string_literal(std::string_view text) {
+    std::string res = "\"";
+    for (const auto c : text) {
+        switch (c) {
+        case '"': res += "\\\""; break;
+        case '\\': res += "\\\\"; break;
+        case '\n': res += "\\n"; break;
+        case '\t': res += "\\t"; break;
+        case '\033': res += "\\033"; break;
+        default: res += c; break;
+        }
     }
+    return res + "\"";
 }
 
+// lazy column in generated code
+struct LazyCode {
+    std::size_t type = 0;
+    std::int64_t size = 0;
+    std::vector<LazyOp> ops;
+
+    // returns the expression computing the element with the given index
+    std::string element(const std::string& index) const {
+        const auto cast = "static_cast<" + std::string {column_code_types[type]} + ">(";
+        auto expr       = cast + index + ")";
+        for (const auto& op : ops)
+            expr = cast + expr + " " + op._op + " " + double_literal(op._value) + ")";
+        return expr;
+    }
+};
 
+// columns and results declared by generated code
+struct CodeModel {
+    // type index of each column
+    std::map<std::string, std::size_t> columns;
+    // number of elements of each column; used to pick tuned code variants
+    std::map<std::string, long long> elements;
+    // names of the result slots
+    std::set<std::string> results;
+    // records element-wise steps as expressions instead of loops
+    bool lazy = false;
+    // columns whose elements are not written to their variable yet
+    std::map<std::string, LazyCode> lazy_columns;
+};
 
-#define KEY(key) constexpr static const char* key = #key;
+// read access to a column in generated code; the column may be lazy
+struct CodeColumn {
+    std::string _variable;
+    std::optional<LazyCode> _lazy;
 
-// ---------------------------- Example Elements ----------------------------
+    // returns true if the elements are computed on access
+    auto lazy() const {
+        return _lazy.has_value();
+    }
 
-namespace conf {
-    namespace print_number {
-        KEY(num)
+    // returns the expression of the number of elements
+    std::string size() const {
+        if (_lazy)
+            return "std::size_t {" + std::to_string(_lazy->size) + "}";
+        return _variable + ".size()";
     }
-    namespace add_values {
-        KEY(cnt)
+
+    // returns the expression testing for no elements
+    std::string empty() const {
+        if (_lazy)
+            return _lazy->size == 0 ? "true" : "false";
+        return _variable + ".empty()";
     }
-    namespace check_value {
-        KEY(ref)
+
+    // returns the expression of the element with the given index
+    std::string at(const std::string& index) const {
+        if (_lazy)
+            return _lazy->element(index);
+        return _variable + "[" + index + "]";
     }
-} // namespace conf
+};
 
-static auto hello_world(const Conf&, Model&) {
-    std::cout << "Hello World!\n";
-    return true;
-}
+// data mode; modified by RecipeStep objects
+class Model {
+public:
+    Model() {};
+    ~Model() {};
 
-static void hello_world_code(const Conf&, CodeLines& code, CodeInfo&) {
-    code.push_back("std::cout << \"Hello World !\\n\";");
-}
+    static constexpr const char* default_column = "data";
+    static constexpr const char* default_result = "res";
 
-static auto print_number(const Conf& conf, Model&) {
-    const auto value = conf.get_value(conf::print_number::num, .0f);
-    std::cout << "Number: \"" << value << "\"\n";
-    return true;
-}
+    std::map<std::string, Column, std::less<>> _columns;
+    std::map<std::string, double, std::less<>> _results;
 
-static void print_number_info(StepInfo& info) {
+    // records element-wise steps in lazy columns instead of writing memory
+    bool _lazy_mode = false;
+    std::map<std::string, LazyColumn, std::less<>> _lazy;
+
+    // allocation of the columns
+    MemorySettings _memory;
+
+    // element-wise steps and reductions only handle the chunks of this shard; see run_sharded
+    unsigned int _shard  = 0;
+    unsigned int _shards = 1;
+
+    // returns the first and the end chunk of the shard; matches the partitioning of parallel_chunks
+    std::pair<std::int64_t, std::int64_t> shard_chunks(std::int64_t chunks) const {
+        return {chunks * _shard / _shards, chunks * (_shard + 1) / _shards};
+    }
+
+    // returns the column with the given name; nullptr if it doesn't exist
+    // a lazy column is written to memory first
+    Column* find_column(std::string_view name) {
+        materialize(name);
+        auto c = _columns.find(name);
+        if (c != _columns.end())
+            return &c->second;
+        return nullptr;
+    }
+
+    // returns the column with the given name; creates it with the given type if it doesn't exist
+    // a lazy column is written to memory first
+    Column& column(std::string_view name, std::size_t type) {
+        materialize(name);
+        auto c = _columns.find(name);
+        if (c == _columns.end())
+            c = _columns.emplace(std::string {name}, make_column(type, _memory)).first;
+        return c->second;
+    }
+
+    // returns the lazy column with the given name; nullptr if it doesn't exist
+    LazyColumn* find_lazy(std::string_view name) {
+        auto c = _lazy.find(name);
+        if (c != _lazy.end())
+            return &c->second;
+        return nullptr;
+    }
+
+    // returns the type index of the stored or lazy column; nullopt if it doesn't exist
+    std::optional<std::size_t> column_type(std::string_view name) const {
+        if (auto c = _columns.find(name); c != _columns.end())
+            return c->second.index();
+        if (auto c = _lazy.find(name); c != _lazy.end())
+            return c->second._type;
+        return std::nullopt;
+    }
+
+    // calls func(ColumnView<T>) for the stored or lazy column without writing it to memory
+    // returns false if the column doesn't exist
+    template <typename FUNC> bool view_column(std::string_view name, FUNC&& func) const {
+        if (auto c = _lazy.find(name); c != _lazy.end()) {
+            visit_lazy(c->second, func);
+            return true;
+        }
+        if (auto c = _columns.find(name); c != _columns.end()) {
+            std::visit([&func](const auto& data) { func(ColumnView {data}); }, c->second);
+            return true;
+        }
+        return false;
+    }
+
+    // writes the lazy column with the given name to memory
+    void materialize(std::string_view name) {
+        auto lazy = _lazy.find(name);
+        if (lazy == _lazy.end())
+            return;
+
+        auto column = make_column(lazy->second._type, _memory);
+        std::visit(
+            [&lazy](auto& data) {
+                data.resize(lazy->second._size);
+                parallel_chunks(data.chunk_count(), [&](std::int64_t c) {
+                    lazy->second.evaluate(
+                        c * data.chunk_elements, data.chunk_size(c), data.chunk(c));
+                });
+            },
+            column);
+
+        _columns.insert_or_assign(std::string {name}, std::move(column));
+        _lazy.erase(lazy);
+    }
+
+    // returns the result slot with the given name; creates it if it doesn't exist
+    double& result(std::string_view name) {
+        auto r = _results.find(name);
+        if (r == _results.end())
+            r = _results.emplace(std::string {name}, 0.0).first;
+        return r->second;
+    }
+
+    // returns the column selected in the Conf
+    static std::string column_name(const Conf& conf) {
+        return conf.get_string(conf::model::column, default_column);
+    }
+
+    // returns the result slot selected in the Conf
+    static std::string result_name(const Conf& conf) {
+        return conf.get_string(conf::model::result, default_result);
+    }
+
+    // returns the name of the variable holding a column in generated code
+    // columns and results have their own prefix, so their variables don't collide with each
+    // other, with the local variables of the steps or with the generated functions
+    static std::string column_variable(const std::string& name) {
+        return "c_" + identifier(name);
+    }
+
+    // returns the name of the variable holding a result slot in generated code
+    static std::string result_variable(const std::string& name) {
+        return "r_" + identifier(name);
+    }
+
+    // returns the name with every character that can't be part of an identifier replaced
+    static std::string identifier(const std::string& name) {
+        auto res = name;
+        for (auto& c : res)
+            if (!std::isalnum(static_cast<unsigned char>(c)))
+                c = '_';
+        return res;
+    }
+
+    // declarations of the columns and results; valid as locals and as members of a struct
+    static void setup_code(CodeLines& code, const CodeModel& model) {
+        for (const auto& [name, type] : model.columns)
+            code.push_back("std::vector<" + std::string {column_code_types[type]} + "> " +
+                           column_variable(name) + ";");
+        for (const auto& name : model.results)
+            code.push_back("double " + result_variable(name) + " = 0.0;");
+    }
+    static void cleanup_code(CodeLines& code, const CodeModel& model) {
+        for (const auto& [name, type] : model.columns) {
+            code.push_back(column_variable(name) + ".clear();");
+            code.push_back(column_variable(name) + ".shrink_to_fit();");
+        }
+    }
+
+    // returns the headers needed by the declarations of setup_code
+    static std::set<std::string> setup_includes(const CodeModel& model) {
+        std::set<std::string> includes;
+        for (const auto& [name, type] : model.columns)
+            if (type >= 2)
+                includes.insert("<cstdint>");
+        return includes;
+    }
+};
+
+// information on the generated code
+struct CodeInfo {
+    explicit CodeInfo(CodeModel& m) : model(m) {}
+
+    // columns and results of the generated code; updated by the step
+    CodeModel& model;
+    bool needs_scope = false;
+    // code variant to emit; index into StepInfo::variants
+    unsigned int variant = 0;
+    // headers needed by the emitted code
+    std::set<std::string> includes;
+
+    // lines emitted before the code of the step; they write lazy columns to memory
+    CodeLines prologue;
+    // true if the code depends on previous steps and not only on the Conf
+    bool depends_on_model = false;
+    // column the code accesses through column() or read_column(); empty if it accesses none
+    std::string accessed_column;
+
+    // returns the variable of the column selected in the Conf; declares it as float if unknown
+    // the code of a lazy column writing it to memory is added to the prologue
+    std::string column(const Conf& conf) {
+        const auto name = Model::column_name(conf);
+        model.columns.try_emplace(name, 0);
+        accessed_column = name;
+
+        const auto var  = Model::column_variable(name);
+        const auto lazy = model.lazy_columns.find(name);
+        if (lazy != model.lazy_columns.end()) {
+            prologue.push_back(var + ".resize(" + std::to_string(lazy->second.size) + ");");
+            prologue.push_back("for (auto i = std::size_t {0}; i < " + var + ".size(); ++i) {" +
+                               var + "[i] = " + lazy->second.element("i") + ";}");
+            model.lazy_columns.erase(lazy);
+            depends_on_model = true;
+        }
+        return var;
+    }
+
+    // returns read access to the column selected in the Conf without writing a lazy column
+    CodeColumn read_column(const Conf& conf) {
+        const auto name = Model::column_name(conf);
+        model.columns.try_emplace(name, 0);
+        accessed_column = name;
+
+        CodeColumn res {Model::column_variable(name), std::nullopt};
+        const auto lazy = model.lazy_columns.find(name);
+        if (lazy != model.lazy_columns.end()) {
+            res._lazy        = lazy->second;
+            depends_on_model = true;
+        }
+        return res;
+    }
+
+    // returns the element type of the column selected in the Conf
+    std::string column_type(const Conf& conf) {
+        const auto name = Model::column_name(conf);
+        return column_code_types[model.columns.try_emplace(name, 0).first->second];
+    }
+
+    // returns the variable of the result slot selected in the Conf; declares it if unknown
+    std::string result(const Conf& conf) {
+        const auto name = Model::result_name(conf);
+        model.results.insert(name);
+        return Model::result_variable(name);
+    }
+};
+
+// how a step runs when the columns are sharded over worker processes
+enum class ShardMode {
+    // runs in the coordinator on the whole columns
+    coordinator,
+    // runs in each worker on its shard; writes every element of the columns it resizes
+    elementwise,
+    // runs in each worker on its shard; the coordinator combines the results of the workers
+    reduction,
+};
+
+// information on the specific step
+struct StepInfo {
+    bool always_same_code     = false;
+    bool returns_stop         = false;
+    const char* stop_variable = nullptr;
+    // names of the code variants the step can emit; empty if there is only one
+    std::span<const char* const> variants;
+    ShardMode shard = ShardMode::coordinator;
+    // operation combining the results of a reduction: '+' or '*'
+    char combine = '+';
+    // the autotuner shuffles the columns before every repetition; for steps depending on the
+    // order of the elements, which the sizing step writes in ascending order
+    bool tune_shuffled = false;
+};
+
+// ---------------------------- cook the recipe ----------------------------
+
+// text reported by run() for each step; instrumented generated code reports the same
+static std::string report_step(unsigned int s, const char* name) {
+    return "\n\033[1;32mStep " + std::to_string(s) + " :\t\033[0m\033[1;36m" + name + "\033[0m\n";
+}
+
+static std::string report_key(const char* key, const ConfValue& v) {
+    return "\t\t\033[1;33mKey: " + std::string {key} + ", Value: " + conf_string(v) + "\033[0m \n";
+}
+
+// the time is printed between prefix and suffix
+static constexpr const char* report_time_prefix = "\n\t\t\033[1;37mTime: ";
+static constexpr const char* report_time_suffix = " ns\t\033[0m\n";
+
+// runs a recipe
+static void run(Recipe& recipe,
+                std::function<void(unsigned int, const char*)> progress,
+                std::function<void(const char*, const ConfValue&)> print_key,
+                std::function<void(long long)> print_time,
+                bool lazy                    = false,
+                const MemorySettings& memory = {}) {
+    Model model;
+    model._lazy_mode = lazy;
+    model._memory    = memory;
+
+    auto start = std::chrono::system_clock::time_point {};
+
+    auto i = 0;
+    for (const auto& s : recipe.all()) {
+  
+        progress(i, s._step->_name);
+
+        for (const auto& [key, v] : s._config)
+            print_key(key, v);
+
+        start = std::chrono::system_clock::now();
+
+        if (!s.execute(model))
+            return;
+
+        const auto end = std::chrono::system_clock::now();
+        const auto diff =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+        print_time(diff);
+        start = end;
+
+        ++i;
+    }
+}
+
+// ---------------------------- Sharded Execution ----------------------------
+
+#ifndef _WIN32
+
+// channel between the coordinator and a worker; the coordinator only depends on this interface,
+// so workers on other nodes just need another implementation
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // sends size bytes; returns false if the channel is closed
+    virtual bool send(const void* data, std::size_t size) = 0;
+
+    // receives exactly size bytes; returns false if the channel is closed
+    virtual bool receive(void* data, std::size_t size) = 0;
+
+    template <typename T> bool send_value(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return send(&value, sizeof(T));
+    }
+
+    template <typename T> bool receive_value(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return receive(&value, sizeof(T));
+    }
+
+    bool send_string(const std::string& text) {
+        return send_value(static_cast<std::uint32_t>(text.size())) &&
+               send(text.data(), text.size());
+    }
+
+    bool receive_string(std::string& text) {
+        auto size = std::uint32_t {0};
+        if (!receive_value(size))
+            return false;
+        text.resize(size);
+        return receive(text.data(), size);
+    }
+};
+
+// Transport over a pair of pipes between processes on the same machine
+class PipeTransport : public Transport {
+public:
+    PipeTransport(int read_fd, int write_fd) : _read(read_fd), _write(write_fd) {}
+
+    ~PipeTransport() override {
+        ::close(_read);
+        ::close(_write);
+    }
+
+    bool send(const void* data, std::size_t size) override {
+        const auto* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            const auto n = ::write(_write, bytes, size);
+            if (n <= 0)
+                return false;
+            bytes += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    bool receive(void* data, std::size_t size) override {
+        auto* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            const auto n = ::read(_read, bytes, size);
+            if (n <= 0)
+                return false;
+            bytes += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+private:
+    const int _read;
+    const int _write;
+};
+
+// POSIX shared memory segment mapped into the process; the creator removes the name again
+class SharedSegment {
+public:
+    // creates or opens the segment with the given name and size in bytes
+    SharedSegment(std::string name, std::size_t size, bool create)
+        : _name(std::move(name)), _size(size), _owner(create) {
+        const auto flags = create ? O_CREAT | O_EXCL | O_RDWR : O_RDWR;
+        const auto fd    = ::shm_open(_name.c_str(), flags, 0600);
+        if (fd < 0)
+            return;
+        if (!create || ::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            auto* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED)
+                _data = p;
+        }
+        ::close(fd);
+    }
+
+    ~SharedSegment() {
+        if (_data)
+            ::munmap(_data, _size);
+        if (_owner)
+            ::shm_unlink(_name.c_str());
+    }
+
+    SharedSegment(const SharedSegment&)            = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    // returns the mapped memory; nullptr if the segment couldn't be mapped
+    void* data() const {
+        return _data;
+    }
+
+    const std::string& name() const {
+        return _name;
+    }
+
+private:
+    const std::string _name;
+    const std::size_t _size;
+    const bool _owner;
+    void* _data = nullptr;
+};
+
+// messages from the coordinator to the workers
+enum class ShardCommand : std::uint8_t {
+    // followed by column name, type index, number of elements and segment name
+    attach,
+    // followed by the index of the step
+    execute,
+    quit,
+};
+
+// answer of a worker to ShardCommand::execute
+struct ShardReply {
+    bool _ok      = true;
+    // result of a reduction over the shard
+    double _value = 0.0;
+};
+
+// makes the column use the memory of the segment; no segment leaves the column empty
+static bool attach_column(Model& m,
+                          const std::string& name,
+                          std::size_t type,
+                          std::int64_t size,
+                          const SharedSegment* segment) {
+    if (segment && !segment->data())
+        return false;
+
+    auto& column = m._columns.insert_or_assign(name, make_column(type)).first->second;
+    if (segment)
+        std::visit(
+            [&](auto& data) {
+                using T = std::decay_t<decltype(data[0])>;
+                data.attach(static_cast<T*>(segment->data()), size);
+            },
+            column);
+    return true;
+}
+
+// runs the commands of the coordinator on the shard of the worker until told to quit
+static void shard_worker(const Recipe& recipe,
+                         unsigned int shard,
+                         unsigned int shards,
+                         Transport& transport) {
+    Model model;
+    model._shard  = shard;
+    model._shards = shards;
+
+    std::map<std::string, std::unique_ptr<SharedSegment>> segments;
+    const auto steps = recipe.all();
+
+    auto command = ShardCommand::quit;
+    while (transport.receive_value(command)) {
+        if (command == ShardCommand::attach) {
+            std::string name, segment_name;
+            auto type = std::size_t {0};
+            auto size = std::int64_t {0};
+            if (!transport.receive_string(name) || !transport.receive_value(type) ||
+                !transport.receive_value(size) || !transport.receive_string(segment_name))
+                return;
+
+            // the previous segment stays mapped until the column refers to the new one
+            std::unique_ptr<SharedSegment> segment;
+            if (!segment_name.empty())
+                segment = std::make_unique<SharedSegment>(
+                    segment_name, static_cast<std::size_t>(size) * column_sizes[type], false);
+            if (!attach_column(model, name, type, size, segment.get()))
+                return;
+            segments[name] = std::move(segment);
+        } else if (command == ShardCommand::execute) {
+            auto index = 0u;
+            if (!transport.receive_value(index) || index >= recipe.count())
+                return;
+
+            const auto s = steps[index];
+            StepInfo info;
+            s._step->_info(info);
+
+            ShardReply reply;
+            reply._ok = s.execute(model);
+            if (info.shard == ShardMode::reduction)
+                reply._value = model.result(Model::result_name(s._config));
+            if (!transport.send_value(reply))
+                return;
+        } else {
+            return;
+        }
+    }
+}
+
+// ignores SIGPIPE during its lifetime
+class IgnoreSigpipe {
+public:
+    IgnoreSigpipe() : _previous(std::signal(SIGPIPE, SIG_IGN)) {}
+    ~IgnoreSigpipe() {
+        std::signal(SIGPIPE, _previous);
+    }
+
+    IgnoreSigpipe(const IgnoreSigpipe&)            = delete;
+    IgnoreSigpipe& operator=(const IgnoreSigpipe&) = delete;
+
+private:
+    using Handler = void (*)(int);
+    const Handler _previous;
+};
+
+// runs a recipe with the columns sharded over the given number of worker processes
+// the columns are stored in shared memory; every worker handles a contiguous range of chunks
+// returns false if the workers can't be started or stop responding
+static bool run_sharded(Recipe& recipe,
+                        unsigned int workers,
+                        std::function<void(unsigned int, const char*)> progress,
+                        std::function<void(const char*, const ConfValue&)> print_key,
+                        std::function<void(long long)> print_time) {
+    workers = std::max(workers, 1u);
+
+    // writing to the pipe of a worker that died must fail instead of terminating the process
+    const IgnoreSigpipe ignore_sigpipe;
+
+    std::vector<std::unique_ptr<Transport>> channels;
+    std::vector<pid_t> pids;
+
+    // output buffered before the fork would be written by every worker
+    std::cout.flush();
+
+    for (auto w = 0u; w < workers; ++w) {
+        int to_worker[2], to_coordinator[2];
+        if (::pipe(to_worker) != 0)
+            return false;
+        if (::pipe(to_coordinator) != 0) {
+            ::close(to_worker[0]);
+            ::close(to_worker[1]);
+            return false;
+        }
+
+        const auto pid = ::fork();
+        if (pid < 0) {
+            for (const auto fd : {to_worker[0], to_worker[1], to_coordinator[0], to_coordinator[1]})
+                ::close(fd);
+            break;
+        }
+        if (pid == 0) {
+            // the worker must not hold the channels of other workers
+            channels.clear();
+            ::close(to_worker[1]);
+            ::close(to_coordinator[0]);
+            PipeTransport transport {to_worker[0], to_coordinator[1]};
+            // the workers share the hardware threads
+            thread_limit() = std::max<std::int64_t>(thread_limit() / workers, 1);
+            shard_worker(recipe, w, workers, transport);
+            std::cout.flush();
+            ::_exit(0);
+        }
+
+        ::close(to_worker[0]);
+        ::close(to_coordinator[1]);
+        channels.push_back(std::make_unique<PipeTransport>(to_coordinator[0], to_worker[1]));
+        pids.push_back(pid);
+    }
+
+    auto connected = pids.size() == workers;
+
+    Model model;
+    std::map<std::string, std::unique_ptr<SharedSegment>> segments;
+    // number of elements of each column as last sent to the workers
+    std::map<std::string, std::int64_t> shared;
+    auto segment_count = 0u;
+
+    auto column_size = [](const Column& column) {
+        return std::visit([](const auto& data) { return data.size(); }, column);
+    };
+
+    // stores the column with the given type and size in a new segment and sends it to the workers
+    // the elements of the current column are copied if copy is set
+    auto share_column = [&](const std::string& name,
+                            std::size_t type,
+                            std::int64_t size,
+                            bool copy) {
+        std::unique_ptr<SharedSegment> segment;
+        if (size > 0) {
+            segment = std::make_unique<SharedSegment>(
+                "/lab_" + std::to_string(::getpid()) + "_" + std::to_string(segment_count++),
+                static_cast<std::size_t>(size) * column_sizes[type], true);
+            if (!segment->data())
+                return false;
+
+            auto column = model._columns.find(name);
+            if (copy && column != model._columns.end() && column->second.index() == type)
+                std::visit(
+                    [&segment, size](const auto& data) {
+                        using T      = std::decay_t<decltype(data[0])>;
+                        auto* target = static_cast<T*>(segment->data());
+                        for (auto c = std::int64_t {0}; c < data.chunk_count(); ++c)
+                            std::copy_n(
+                                data.chunk(c),
+                                std::min(data.chunk_size(c), size - c * data.chunk_elements),
+                                target + c * data.chunk_elements);
+                    },
+                    column->second);
+        }
+
+        const auto segment_name = segment ? segment->name() : std::string {};
+        for (auto& channel : channels)
+            if (!channel->send_value(ShardCommand::attach) || !channel->send_string(name) ||
+                !channel->send_value(type) || !channel->send_value(size) ||
+                !channel->send_string(segment_name))
+                return false;
+
+        attach_column(model, name, type, size, segment.get());
+        segments[name] = std::move(segment);
+        shared[name]   = size;
+        return true;
+    };
+
+    // shares the columns created or resized by steps of the coordinator
+    auto share_columns = [&]() {
+        for (const auto& [name, column] : model._columns) {
+            const auto size = column_size(column);
+            auto known      = shared.find(name);
+            if (known == shared.end() || known->second != size)
+                if (!share_column(name, column.index(), size, true))
+                    return false;
+        }
+        return true;
+    };
+
+    // the coordinator learns the sizes of the columns written by an element-wise step
+    // by running it on lazy copies of the columns
+    auto resize_columns = [&](const RecipeStepInstance& s) {
+        Model shape;
+        shape._lazy_mode = true;
+        for (const auto& [name, column] : model._columns)
+            shape._lazy.emplace(name, LazyColumn {column.index(), column_size(column), {}});
+        s.execute(shape);
+
+        for (const auto& [name, lazy] : shape._lazy) {
+            auto column = model._columns.find(name);
+            if (column != model._columns.end() && column->second.index() == lazy._type &&
+                column_size(column->second) == lazy._size)
+                continue;
+            // the step writes every element, so nothing is copied
+            if (!share_column(name, lazy._type, lazy._size, false))
+                return false;
+        }
+        return true;
+    };
+
+    // sends the step to all workers and collects their answers
+    auto execute = [&](unsigned int index, std::vector<ShardReply>& replies) {
+        replies.resize(channels.size());
+        for (auto& channel : channels)
+            if (!channel->send_value(ShardCommand::execute) || !channel->send_value(index))
+                return false;
+        for (auto w = 0u; w < channels.size(); ++w)
+            if (!channels[w]->receive_value(replies[w]))
+                return false;
+        return true;
+    };
+
+    auto start = std::chrono::system_clock::time_point {};
+    std::vector<ShardReply> replies;
+
+    auto i = 0u;
+    for (const auto& s : recipe.all()) {
+        if (!connected)
+            break;
+
+        progress(i, s._step->_name);
+
+        for (const auto& [key, v] : s._config)
+            print_key(key, v);
+
+        start = std::chrono::system_clock::now();
+
+        StepInfo info;
+        s._step->_info(info);
+
+        auto ok = true;
+        if (info.shard == ShardMode::elementwise) {
+            connected = share_columns() && resize_columns(s) && execute(i, replies);
+            for (const auto& r : replies)
+                ok = ok && r._ok;
+        } else if (info.shard == ShardMode::reduction) {
+            connected = share_columns() && execute(i, replies);
+            // partial results are combined in the order of the shards, like the chunks of run()
+            auto& res = model.result(Model::result_name(s._config));
+            res       = info.combine == '*' ? 1.0 : 0.0;
+            for (const auto& r : replies) {
+                res = info.combine == '*' ? res * r._value : res + r._value;
+                ok  = ok && r._ok;
+            }
+        } else {
+            ok = s.execute(model);
+        }
+
+        if (!connected || !ok)
+            break;
+
+        const auto end = std::chrono::system_clock::now();
+        print_time(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        start = end;
+
+        ++i;
+    }
+
+    for (auto& channel : channels)
+        channel->send_value(ShardCommand::quit);
+    channels.clear();
+    for (const auto pid : pids)
+        ::waitpid(pid, nullptr, 0);
+
+    return connected;
+}
+
+#endif
+
+// ---------------------------- Tuning Database ----------------------------
+
+// size bucket of the given number of elements; each bucket covers a factor of 16
+static unsigned int size_bucket(long long elements) {
+    const auto n = static_cast<unsigned long long>(std::max(elements, 0LL));
+    return static_cast<unsigned int>(std::bit_width(n)) / 4u;
+}
+
+// representative number of elements of the given size bucket
+static long long bucket_elements(unsigned int bucket) {
+    return 1LL << (bucket * 4u + 2u);
+}
+
+// stores the fastest code variant per step and size bucket
+class TuningDB {
+public:
+    TuningDB()  = default;
+    ~TuningDB() = default;
+
+    // returns the variant stored for the given step and bucket
+    std::optional<unsigned int> get_variant(const char* step, unsigned int bucket) const {
+        auto v = _entries.find({step, bucket});
+        if (v != _entries.end())
+            return v->second;
+        return std::nullopt;
+    }
+
+    // stores the variant for the given step and bucket
+    void set_variant(const char* step, unsigned int bucket, unsigned int variant) {
+        _entries[{step, bucket}] = variant;
+    }
+
+    // stores the database to text file
+    void store(const char* file) const {
+        std::ofstream file_stream {file, std::ofstream::out};
+        for (const auto& [key, variant] : _entries)
+            file_stream << key.first << ":" << key.second << ":" << variant << NL;
+    }
+
+    // loads the database from text file; returns false if the file can't be read
+    bool load(const char* file) {
+        std::ifstream file_stream {file, std::ifstream::in};
+        if (!file_stream)
+            return false;
+
+        std::string line;
+        while (std::getline(file_stream, line)) {
+            const auto a = line.find(':');
+            const auto b = line.rfind(':');
+            if (a == std::string::npos || a == b)
+                continue;
+            // lines that don't parse are skipped
+            try {
+                const auto bucket  = std::stoul(line.substr(a + 1, b - a - 1));
+                const auto variant = std::stoul(line.substr(b + 1));
+                _entries[{line.substr(0, a), static_cast<unsigned int>(bucket)}] =
+                    static_cast<unsigned int>(variant);
+            } catch (...) {
+            }
+        }
+        return true;
+    }
+
+private:
+    std::map<std::pair<std::string, unsigned int>, unsigned int> _entries;
+};
+
+// appends the includes not yet listed; keeps the order of the list
+static void merge_includes(std::vector<std::string>& list, const std::set<std::string>& includes) {
+    for (const auto& include : includes)
+        if (std::find(list.begin(), list.end(), include) == list.end())
+            list.push_back(include);
+}
+
+// settings of the code generation
+struct CodeSettings {
+    // database of tuned code variants; nullptr uses the default variants
+    const TuningDB* tuning = nullptr;
+    // records element-wise steps as expressions evaluated by the consuming steps
+    bool lazy = false;
+    // number of translation units create_code_func defines the functions and the parts of the
+    // steps in; 1 keeps them inline in the header
+    unsigned int units = 1;
+    // times every step and prints the report of run() at exit
+    bool instrument = false;
+    // with instrument, also reports the number of elements of the column each step accesses
+    bool count_elements = false;
+};
+
+// text of generated code; appended to one pre-sized buffer and written to file at once
+class CodeWriter {
+public:
+    explicit CodeWriter(std::size_t reserve = 4096) {
+        _text.reserve(reserve);
+    }
+    ~CodeWriter() = default;
+
+    // appends text and integers
+    template <typename... ARGS> CodeWriter& add(const ARGS&... args) {
+        (append(args), ...);
+        return *this;
+    }
+
+    // appends the given number of tabs
+    CodeWriter& tabs(unsigned int count) {
+        _text.append(count, '\t');
+        return *this;
+    }
+
+    // appends a line indented by the given number of tabs
+    CodeWriter& line(unsigned int count, std::string_view text) {
+        tabs(count);
+        _text.append(text);
+        _text.push_back('\n');
+        return *this;
+    }
+
+    const std::string& text() const {
+        return _text;
+    }
+
+    auto size() const {
+        return _text.size();
+    }
+
+    // writes the text to the given file; returns false on failure
+    bool write(const std::filesystem::path& file) const {
+        std::ofstream stream {file, std::ofstream::out | std::ofstream::binary};
+        stream.write(_text.data(), static_cast<std::streamsize>(_text.size()));
+        return static_cast<bool>(stream);
+    }
+
+private:
+    void append(std::string_view text) {
+        _text.append(text);
+    }
+
+    void append(char c) {
+        _text.push_back(c);
+    }
+
+    template <typename T> void append(T value) requires std::is_integral_v<T> {
+        char buffer[24];
+        const auto end = std::to_chars(buffer, buffer + sizeof buffer, value).ptr;
+        _text.append(buffer, end);
+    }
+
+    std::string _text;
+};
+
+// creates the code of the step; the prologue of the step goes first
+static void make_step_code(const RecipeStepInstance& s, CodeLines& code, CodeInfo& info) {
+    s.make_code(code, info);
+    if (!info.prologue.empty())
+        code.insert(code.begin(), info.prologue.begin(), info.prologue.end());
+}
+
+// picks the code variant of the step based on the tuning database
+static void select_variant(const RecipeStepInstance& s,
+                           const StepInfo& step_info,
+                           const TuningDB* tuning,
+                           CodeInfo& info) {
+    info.variant = 0;
+    if (tuning == nullptr || step_info.variants.empty())
+        return;
+
+    const auto elements = info.model.elements.find(Model::column_name(s._config));
+    if (elements == info.model.elements.end())
+        return;
+
+    const auto variant = tuning->get_variant(s._step->_name, size_bucket(elements->second));
+    if (variant && variant.value() < step_info.variants.size())
+        info.variant = variant.value();
+}
+
+// returns the current time as text for the header of generated files
+static std::string code_timestamp() {
+    const auto now  = std::chrono::system_clock::now();
+    const auto time = std::chrono::system_clock::to_time_t(now);
+    char buffer[26];
+#ifdef _WIN32
+    ctime_s(buffer, sizeof buffer, &time);
+#else
+    ctime_r(&time, buffer);
+#endif
+    return buffer;
+}
+
+// table of the report text of every step; _report() prints the entries of the steps started
+static void instrument_reports_code(Recipe& recipe, CodeLines& code) {
+    code.push_back("static const char* const _step_reports[] = {");
+    for (auto i = 0u; i < recipe.count(); ++i) {
+        const auto s = recipe.instance(i);
+        auto text    = report_step(i, s._step->_name);
+        for (const auto& [key, v] : s._config)
+            text += report_key(key, v);
+        code.push_back("\t" + string_literal(text) + ",");
+    }
+    code.push_back("};");
+}
+
+// statements of _report(); prints the text of run() for the steps started
+static void instrument_report_code(CodeLines& code, bool count_elements) {
+    code.push_back("for (auto s = std::size_t {0}; s < _steps; ++s) {");
+    code.push_back("\tstd::cout << _step_reports[s];");
+    code.push_back("\tif (_step_times[s] >= 0)");
+    code.push_back("\t\tstd::cout << " + string_literal(report_time_prefix) +
+                   " << _step_times[s] << " + string_literal(report_time_suffix) + ";");
+    if (count_elements) {
+        code.push_back("\tif (_step_elements[s] >= 0)");
+        code.push_back("\t\tstd::cout << " + string_literal("\t\t\033[1;37mElements: ") +
+                       " << _step_elements[s] << " + string_literal("\033[0m\n") + ";");
+    }
+    code.push_back("}");
+}
+
+// declarations of instrumented code; the functions _step_begin(s), _step_end(s) and _report()
+// are lambdas in main, or member functions of RecipeState if members is set
+// the member _report() is only declared; it is defined next to the table of instrument_reports_code
+static void
+instrument_setup_code(Recipe& recipe, CodeLines& code, bool count_elements, bool members = false) {
+    const auto cnt   = std::to_string(recipe.count());
+    const auto close = members ? "}" : "};";
+    // returns the first line of the function of the given name
+    auto open = [members](const char* name, const char* parameters) {
+        if (members)
+            return std::string {"void "} + name + "(" + parameters + ") {";
+        return std::string {"const auto "} + name + " = [&](" + parameters + ") {";
+    };
+
+    if (!members)
+        instrument_reports_code(recipe, code);
+    code.push_back("std::vector<long long> _step_times = std::vector<long long>(" + cnt + ", -1);");
+    if (count_elements)
+        code.push_back("std::vector<long long> _step_elements = std::vector<long long>(" + cnt +
+                       ", -1);");
+    code.push_back("std::size_t _steps = 0;");
+    code.push_back("std::chrono::steady_clock::time_point _step_start = "
+                   "std::chrono::steady_clock::now();");
+    code.push_back(open("_step_begin", "std::size_t s"));
+    code.push_back("\t_steps = s + 1;");
+    code.push_back("\t_step_start = std::chrono::steady_clock::now();");
+    code.push_back(close);
+    code.push_back(open("_step_end", "std::size_t s"));
+    code.push_back("\tconst auto end = std::chrono::steady_clock::now();");
+    code.push_back("\t_step_times[s] =");
+    code.push_back(
+        "\t\tstd::chrono::duration_cast<std::chrono::nanoseconds>(end - _step_start).count();");
+    code.push_back(close);
+    if (members) {
+        code.push_back("void _report();");
+        return;
+    }
+    code.push_back(open("_report", ""));
+    CodeLines report;
+    instrument_report_code(report, count_elements);
+    for (const auto& line : report)
+        code.push_back("\t" + line);
+    code.push_back(close);
+}
+
+// returns the expression of the number of elements of the column the step accessed;
+// empty if the step accessed no column
+static std::string instrument_elements(const CodeInfo& info, const CodeModel& model) {
+    const auto& name = info.accessed_column;
+    if (name.empty() || !model.columns.contains(name))
+        return {};
+    const auto lazy = model.lazy_columns.find(name);
+    if (lazy != model.lazy_columns.end())
+        return std::to_string(lazy->second.size);
+    return Model::column_variable(name) + ".size()";
+}
+
+// returns the statements recording the end of the given step
+static std::string instrument_end_code(unsigned int step, const std::string& elements) {
+    const auto index = std::to_string(step);
+    auto res         = "_step_end(" + index + ");";
+    if (!elements.empty())
+        res += " _step_elements[" + index + "] = static_cast<long long>(" + elements + ");";
+    return res;
+}
+
+// create code from the Recipe
+static void create_code(Recipe& recipe, const char* file, const CodeSettings& settings = {}) {
+
+    CodeWriter body {recipe.count() * std::size_t {96}};
+
+    CodeLines code;
+    code.reserve(64);
+
+    // instrumented code times every step; a recipe without steps has nothing to report
+    const auto instrument = settings.instrument && recipe.count() != 0;
+
+    std::vector<std::string> includes {"<vector>", "<iostream>"};
+    if (instrument)
+        includes.push_back("<chrono>");
+
+    CodeModel model;
+    model.lazy = settings.lazy;
+
+    auto index = 0u;
+    for (const auto& s: recipe.all()) {
+    
+            StepInfo stepInfo;
+            s._step->_info(stepInfo);
+
+            CodeInfo info {model};
+            select_variant(s, stepInfo, settings.tuning, info);
+
+            code.clear();
+            make_step_code(s, code, info);
+
+            merge_includes(includes, info.includes);
+
+            body.add(NL);
+            if (instrument)
+                body.tabs(1).add("_step_begin(", std::to_string(index), ");", NL);
+            if (info.needs_scope)
+                body.line(1, "{");
+
+            const auto tabs = info.needs_scope ? 2u : 1u;
+
+            body.tabs(tabs).add("// ", s._step->_name, NL);
+
+            if (info.variant != 0)
+                body.tabs(tabs).add("// variant : ", stepInfo.variants[info.variant], NL);
+
+            for (const auto& [key, v] : s._config)
+                body.tabs(tabs).add("// ", key, " : ", conf_string(v), NL);
+
+            for (const auto& line : code)
+                body.line(tabs, line);
+
+            if (stepInfo.returns_stop) {
+                body.tabs(tabs).add("if (!", stepInfo.stop_variable, ") {", NL);
+                if (instrument)
+                    body.line(tabs + 1, "_report();");
+                body.line(tabs + 1, "_cleanup();");
+                body.line(tabs + 1, "return 0;");
+                body.line(tabs, "}");
+            }
+
+            if (info.needs_scope)
+                body.line(1, "}");
+
+            if (instrument) {
+                const auto elements =
+                    settings.count_elements ? instrument_elements(info, model) : std::string {};
+                body.line(1, instrument_end_code(index, elements));
+            }
+            ++index;
+       
+    }
+
+    body.add(NL);
+    if (instrument)
+        body.line(1, "_report();");
+    body.line(1, "_cleanup();");
+    body.add(NL);
+    body.line(1, "return 0;");
+    body.add("}", NL);
+
+    // the declarations cover all columns and results used by the steps
+    CodeWriter stream {body.size() + 4096};
+
+    stream.add("// ", code_timestamp(), NL);
+
+    merge_includes(includes, Model::setup_includes(model));
+    for (const auto& include : includes)
+        stream.add("#include", include, NL);
+    stream.add(NL, "int main() {", NL, NL);
+
+    code.clear();
+    Model::setup_code(code, model);
+    if (instrument)
+        instrument_setup_code(recipe, code, settings.count_elements);
+    for (const auto& line : code)
+        stream.line(1, line);
+
+    code.clear();
+    Model::cleanup_code(code, model);
+    stream.add(NL);
+    // reserved name like the other symbols of the generated code
+    stream.line(1, "const auto _cleanup = [&]() {");
+    for (const auto& line : code)
+        stream.line(2, line);
+    stream.line(1, "};");
+
+    stream.add(body.text());
+    stream.write(file);
+}
+
+// returns the path of the given translation unit of the functions declared in the header
+static std::filesystem::path code_unit_file(const char* header_file, unsigned int unit) {
+    auto path = std::filesystem::path {header_file};
+    auto name = path.stem().string();
+    name += "_";
+    name += std::to_string(unit);
+    name += ".cpp";
+    return path.replace_filename(name);
+}
+
+// struct of the code of create_code_func; holds the columns and results, the steps are its
+// member functions
+static constexpr const char* code_state = "RecipeState";
+
+// steps per part of the code of create_code_func; main calls the parts in order
+static constexpr unsigned int code_part_steps = 1024;
+
+// returns the name of the member function running the given part of the steps
+static std::string code_part_name(unsigned int part) {
+    return "run_part_" + std::to_string(part);
+}
+
+// create code from the Recipe
+// the steps are split into parts, which are spread over the translation units with the functions
+// with CodeSettings::units > 1 the functions are defined in the files returned by code_unit_file
+static void create_code_func(Recipe& recipe,
+                             const char* cpp_file,
+                             const char* header_file,
+                             const CodeSettings& settings = {}) {
+    const auto cnt = recipe.count();
+
+    // generated function; steps with identical code share one
+    struct Function {
+        std::string _name;
+        std::string _comments;
+        std::string _body;
+        bool _returns_stop = false;
+    };
+
+    std::vector<Function> functions;
+    // functions by hash of their code
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> by_hash;
+    std::unordered_set<std::string> names;
+    // function called by each step
+    std::vector<std::uint32_t> step_function(cnt);
+
+    // instrumented code times every step; a recipe without steps has nothing to report
+    const auto instrument = settings.instrument && cnt != 0;
+
+    std::vector<std::string> includes {"<vector>", "<iostream>"};
+    if (instrument)
+        includes.push_back("<chrono>");
+
+    CodeModel model;
+    model.lazy = settings.lazy;
+
+    CodeLines code;
+    code.reserve(64);
+    std::string body;
+    std::string name;
+
+    // statements recording the end of each step in main
+    std::vector<std::string> step_end(instrument ? cnt : 0);
+
+    for (auto i = 0u; i < cnt; ++i) {
+        const auto s = recipe.instance(i);
+
+        StepInfo stepInfo;
+        s._step->_info(stepInfo);
+
+        CodeInfo info {model};
+        select_variant(s, stepInfo, settings.tuning, info);
+
+        code.clear();
+        make_step_code(s, code, info);
+
+        if (instrument) {
+            const auto elements =
+                settings.count_elements ? instrument_elements(info, model) : std::string {};
+            step_end[i] = instrument_end_code(i, elements);
+        }
+
+        body.clear();
+        for (const auto& line : code) {
+            body += TAB;
+            body += line;
+            body += NL;
+        }
+        if (stepInfo.returns_stop && stepInfo.stop_variable) {
+            body += "\treturn ";
+            body += stepInfo.stop_variable;
+            body += ";\n";
+        }
+
+        const auto returns_stop = stepInfo.returns_stop;
+        const auto hash         = hash_text(body) ^ static_cast<std::uint64_t>(returns_stop);
+
+        auto& candidates = by_hash[hash];
+        const auto found = std::find_if(candidates.begin(), candidates.end(), [&](auto f) {
+            return functions[f]._returns_stop == returns_stop && functions[f]._body == body;
+        });
+        if (found != candidates.end()) {
+            step_function[i] = *found;
+            continue;
+        }
+
+        // steps depending on their Conf or on previous steps are named after their index
+        name = s._step->_name;
+        if (info.variant != 0) {
+            name += "_";
+            name += stepInfo.variants[info.variant];
+        }
+        if (!stepInfo.always_same_code || !s._config.empty() || info.depends_on_model ||
+            names.contains(name)) {
+            char index[16];
+            const auto end = std::to_chars(index, index + sizeof index, i).ptr;
+            name += "_";
+            name.append(index, end);
+        }
+
+        std::string comments;
+        for (const auto& [key, v] : s._config) {
+            comments += "\t// ";
+            comments += key;
+            comments += " : ";
+            comments += conf_string(v);
+            comments += NL;
+        }
+
+        merge_includes(includes, info.includes);
+
+        step_function[i] = static_cast<std::uint32_t>(functions.size());
+        candidates.push_back(step_function[i]);
+        names.insert(name);
+        functions.push_back({name, std::move(comments), body, returns_stop});
+    }
+
+    merge_includes(includes, Model::setup_includes(model));
+
+    // the steps run in parts of code_part_steps steps
+    const auto parts = (cnt + code_part_steps - 1) / code_part_steps;
+
+    const auto units            = std::max(settings.units, 1u);
+    const auto inline_functions = units == 1;
+
+    auto write_function = [&](CodeWriter& writer, const Function& f) {
+        writer.add(inline_functions ? "inline " : "",
+                   f._returns_stop ? "bool " : "void ",
+                   code_state,
+                   "::",
+                   f._name,
+                   "()",
+                   NL);
+        writer.add("{", NL, f._comments, f._body, "}", NL, NL);
+    };
+
+    // runs the steps of the part in order; returns false if a step stops the recipe
+    auto write_part = [&](CodeWriter& writer, unsigned int part) {
+        writer.add(inline_functions ? "inline " : "", "bool ", code_state, "::");
+        writer.add(code_part_name(part), "()", NL, "{", NL);
+        const auto last = std::min(cnt, (part + 1) * code_part_steps);
+        for (auto i = part * code_part_steps; i < last; ++i) {
+            const auto& f = functions[step_function[i]];
+            if (instrument)
+                writer.add(TAB, "_step_begin(", std::to_string(i), ");", NL);
+            if (f._returns_stop)
+                writer.add("\tif (!", f._name, "())", NL, "\t\treturn false;", NL);
+            else
+                writer.add(TAB, f._name, "();", NL);
+            if (instrument)
+                writer.line(1, step_end[i]);
+        }
+        writer.add("\treturn true;", NL, "}", NL, NL);
+    };
+
+    auto write_cleanup = [&](CodeWriter& writer) {
+        CodeLines cleanup;
+        Model::cleanup_code(cleanup, model);
+
+        writer.add(inline_functions ? "inline " : "", "void ", code_state, "::_cleanup()", NL);
+        writer.add("{", NL);
+        for (const auto& line : cleanup)
+            writer.line(1, line);
+        writer.add("}", NL, NL);
+    };
+
+    // bytes of the calls of a part
+    const auto part_size = std::size_t {code_part_steps} * (instrument ? 96 : 32) + 64;
+
+    {
+        auto size = std::size_t {4096} + parts * 32;
+        for (const auto& f : functions)
+            size += 2 * f._name.size() + 32;
+        if (inline_functions) {
+            for (const auto& f : functions)
+                size += f._comments.size() + f._body.size();
+            size += parts * part_size;
+        }
+
+        CodeWriter header_stream {size};
+
+        header_stream.add("#pragma once", NL);
+        for (const auto& include : includes)
+            header_stream.add("#include", include, NL);
+        header_stream.add(NL);
+
+        // the columns and results are members, so the steps and the parts take no arguments
+        header_stream.add("struct ", code_state, " {", NL);
+        {
+            CodeLines members;
+            Model::setup_code(members, model);
+            if (instrument)
+                instrument_setup_code(recipe, members, settings.count_elements, true);
+            for (const auto& line : members)
+                header_stream.line(1, line);
+        }
+        header_stream.add(NL);
+        for (const auto& f : functions)
+            header_stream.add(TAB, f._returns_stop ? "bool " : "void ", f._name, "();", NL);
+        header_stream.line(1, "void _cleanup();");
+        for (auto part = 0u; part < parts; ++part)
+            header_stream.add("\tbool ", code_part_name(part), "();", NL);
+        header_stream.add("};", NL, NL);
+
+        if (inline_functions) {
+            for (const auto& f : functions)
+                write_function(header_stream, f);
+            write_cleanup(header_stream);
+            for (auto part = 0u; part < parts; ++part)
+                write_part(header_stream, part);
+        }
+
+        header_stream.write(header_file);
+    }
+
+    // contiguous ranges of the functions, then of the parts, go to the same translation unit
+    const auto definitions = functions.size() + parts;
+    for (auto unit = 0u; !inline_functions && unit < units; ++unit) {
+        const auto first = definitions * unit / units;
+        const auto last  = definitions * (unit + 1) / units;
+
+        CodeWriter unit_stream {(last - first) * part_size + 4096};
+        unit_stream.add("#include \"", header_file, "\"", NL, NL);
+        for (auto d = first; d < last; ++d) {
+            if (d < functions.size())
+                write_function(unit_stream, functions[d]);
+            else
+                write_part(unit_stream, static_cast<unsigned int>(d - functions.size()));
+        }
+        if (unit == 0)
+            write_cleanup(unit_stream);
+
+        unit_stream.write(code_unit_file(header_file, unit));
+    }
+
+    {
+        CodeWriter cpp_stream {parts * 64 + (instrument ? cnt * 128 : 0) + 4096};
+
+        cpp_stream.add("#include \"", header_file, "\"", NL, NL);
+
+        if (instrument) {
+            CodeLines report;
+            instrument_reports_code(recipe, report);
+            report.push_back("");
+            report.push_back("void " + std::string {code_state} + "::_report() {");
+            CodeLines statements;
+            instrument_report_code(statements, settings.count_elements);
+            for (const auto& line : statements)
+                report.push_back("\t" + line);
+            report.push_back("}");
+            for (const auto& line : report)
+                cpp_stream.line(0, line);
+            cpp_stream.add(NL);
+        }
+
+        cpp_stream.add("int main() {", NL, NL);
+        cpp_stream.add(TAB, code_state, " state;", NL, NL);
+
+        if (parts != 0) {
+            cpp_stream.add("\tbool (", code_state, "::*const parts[])() = {");
+            for (auto part = 0u; part < parts; ++part)
+                cpp_stream.add(part == 0 ? "" : ", ", "&", code_state, "::", code_part_name(part));
+            cpp_stream.add("};", NL);
+            cpp_stream.line(1, "for (const auto part : parts)");
+            cpp_stream.line(2, "if (!(state.*part)())");
+            cpp_stream.line(3, "break;");
+            cpp_stream.add(NL);
+        }
+
+        if (instrument)
+            cpp_stream.line(1, "state._report();");
+        cpp_stream.line(1, "state._cleanup();");
+
+        cpp_stream.add(NL, "\treturn 0;", NL);
+        cpp_stream.add("}", NL);
+
+        cpp_stream.write(cpp_file);
+    }
+}
+
+// ---------------------------- Autotuning ----------------------------
+
+// settings of the autotuner
+struct TuneSettings {
+    // command compiling a single source file; the source and "-o <exe>" are appended
+    std::string compiler = "c++ -O2 -std=c++20 -pthread";
+    // directory for the generated benchmark programs
+    std::filesystem::path work_dir = std::filesystem::temp_directory_path() / "lab_tune";
+    // size buckets to benchmark
+    unsigned int min_bucket = 1;
+    unsigned int max_bucket = 6;
+    // number of timed repetitions; the fastest one counts
+    unsigned int repetitions = 5;
+};
+
+// compiles and runs a program benchmarking one variant of the step; returns the time in ns
+static std::optional<long long> benchmark_variant(const RecipeStep* step,
+                                                  unsigned int variant,
+                                                  const RecipeStep* sizing_step,
+                                                  const char* sizing_key,
+                                                  long long elements,
+                                                  const TuneSettings& settings) {
+    // the sizing step creates the representative Model; the key is ignored by other steps
+    Conf conf;
+    conf[sizing_key] = static_cast<std::int64_t>(elements);
+
+    CodeModel model;
+
+    CodeLines prepare;
+    CodeInfo prepare_info {model};
+    sizing_step->_code(conf, prepare, prepare_info);
+
+    CodeLines code;
+    CodeInfo info {model};
+    info.variant = variant;
+    step->_code(conf, code, info);
+
+    StepInfo step_info;
+    step->_info(step_info);
+
+    CodeLines setup;
+    Model::setup_code(setup, model);
+
+    auto includes = prepare_info.includes;
+    includes.insert(info.includes.begin(), info.includes.end());
+    includes.merge(Model::setup_includes(model));
+    includes.insert({"<vector>", "<iostream>", "<chrono>", "<limits>", "<algorithm>"});
+    if (step_info.tune_shuffled)
+        includes.insert("<random>");
+
+    const auto base =
+        settings.work_dir / (std::string(step->_name) + "_" + std::to_string(variant));
+    auto exe        = base;
+#ifdef _WIN32
+    exe += ".exe";
+#endif
+    const auto src = std::filesystem::path(base).replace_extension(".cpp");
+    const auto out = std::filesystem::path(base).replace_extension(".txt");
+
+    {
+        std::ofstream stream {src, std::ofstream::out};
+
+        for (const auto& include : includes)
+            stream << "#include" << include << NL;
+
+        stream << NL << "int main() {" << NL;
+        for (const auto& line : setup)
+            stream << "\t" << line << NL;
+
+        stream << "\t{" << NL;
+        for (const auto& line : prepare)
+            stream << "\t\t" << line << NL;
+        stream << "\t}" << NL;
+
+        stream << "\tauto best = std::numeric_limits<long long>::max();" << NL;
+        stream << "\tfor (auto rep = 0u; rep < " << settings.repetitions << "u; ++rep) {" << NL;
+        // every repetition gets other input, not the output of the previous one
+        if (step_info.tune_shuffled)
+            for (const auto& [name, type] : model.columns)
+                stream << "\t\tstd::shuffle(" << Model::column_variable(name) << ".begin(), "
+                       << Model::column_variable(name) << ".end(), std::mt19937 {rep});" << NL;
+        stream << "\t\tconst auto start = std::chrono::steady_clock::now();" << NL;
+        stream << "\t\t{" << NL;
+        for (const auto& line : code)
+            stream << "\t\t\t" << line << NL;
+        stream << "\t\t}" << NL;
+        stream << "\t\tconst auto end = std::chrono::steady_clock::now();" << NL;
+        stream << "\t\tbest = std::min<long long>(best, "
+                  "std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());"
+               << NL;
+        stream << "\t}" << NL;
+        // keep the results observable so the timed code can't be removed
+        for (const auto& [name, type] : model.columns)
+            stream << "\tstd::cerr << " << Model::column_variable(name)
+                   << ".size() << \"\\n\";" << NL;
+        for (const auto& name : model.results)
+            stream << "\tstd::cerr << " << Model::result_variable(name) << " << \"\\n\";" << NL;
+        stream << "\tstd::cout << best << \"\\n\";" << NL;
+        stream << "\treturn 0;" << NL;
+        stream << "}" << NL;
+    }
+
+    const auto compile =
+        settings.compiler + " \"" + src.string() + "\" -o \"" + exe.string() + "\"";
+    if (std::system(compile.c_str()) != 0)
+        return std::nullopt;
+
+    const auto execute = "\"" + exe.string() + "\" > \"" + out.string() + "\" 2>&1";
+    if (std::system(execute.c_str()) != 0)
+        return std::nullopt;
+
+    // the time is the last line of the output
+    std::ifstream result {out, std::ifstream::in};
+    std::string line, last;
+    while (std::getline(result, line))
+        if (!line.empty())
+            last = line;
+
+    try {
+        return std::stoll(last);
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+// benchmarks all code variants of all registered steps and stores the fastest in the database
+static void tune(const Registry& reg,
+                 const char* sizing_step_id,
+                 const char* sizing_key,
+                 TuningDB& tuning,
+                 const TuneSettings& settings,
+                 std::function<void(const char*, unsigned int, const char*, long long)> progress) {
+    const auto sizing_step = reg.get_step(sizing_step_id);
+    if (!sizing_step)
+        return;
+
+    std::filesystem::create_directories(settings.work_dir);
+
+    for (auto i = 0u; i < reg.get_count(); ++i) {
+        const auto* step = reg.get_step(i).value();
+
+        StepInfo info;
+        step->_info(info);
+        if (info.variants.size() < 2)
+            continue;
+
+        for (auto bucket = settings.min_bucket; bucket <= settings.max_bucket; ++bucket) {
+            const auto elements = bucket_elements(bucket);
+
+            auto best_time    = std::numeric_limits<long long>::max();
+            auto best_variant = std::optional<unsigned int> {};
+
+            for (auto v = 0u; v < info.variants.size(); ++v) {
+                const auto time = benchmark_variant(
+                    step, v, sizing_step.value(), sizing_key, elements, settings);
+                if (!time)
+                    continue;
+
+                progress(step->_name, bucket, info.variants[v], time.value());
+
+                if (time.value() < best_time) {
+                    best_time    = time.value();
+                    best_variant = v;
+                }
+            }
+
+            if (best_variant)
+                tuning.set_variant(step->_name, bucket, best_variant.value());
+        }
+    }
+}
+
+
+// ---------------------------- Example Elements ----------------------------
+
+namespace conf {
+    namespace print_number {
+        KEY(num)
+    }
+    namespace add_values {
+        KEY(cnt)
+    }
+    namespace check_value {
+        KEY(ref)
+    }
+} // namespace conf
+
+static auto hello_world(const Conf&, Model&) {
+    std::cout << "Hello World!\n";
+    return true;
+}
+
+static void hello_world_code(const Conf&, CodeLines& code, CodeInfo&) {
+    code.push_back("std::cout << \"Hello World !\\n\";");
+}
+
+static auto print_number(const Conf& conf, Model&) {
+    const auto value = conf.get_value(conf::print_number::num, .0f);
+    std::cout << "Number: \"" << value << "\"\n";
+    return true;
+}
+
+static void print_number_info(StepInfo& info) {
+    info.always_same_code = false;
+}
+
+static void print_number_code(const Conf& conf, CodeLines& code, CodeInfo&) {
+    const auto say    = conf.get_value(conf::print_number::num, .0f);
+    const auto sayStr = double_literal(say);
+    code.push_back("std::cout<<\"Number: \"<<" + sayStr + "<<\"\\n\";");
+}
+
+static auto add_values(const Conf& conf, Model& m) {
+    const auto cnt =
+        std::max(conf.get_value(conf::add_values::cnt, std::int64_t {0}), std::int64_t {0});
+    const auto name = Model::column_name(conf);
+    // an existing column keeps its type
+    const auto type = m.column_type(name).value_or(
+        column_type(conf.get_string(conf::model::type, column_type_names[0])));
+
+    if (m._lazy_mode) {
+        m._columns.erase(name);
+        m._lazy.insert_or_assign(name, LazyColumn {type, cnt, {}});
+        return true;
+    }
+
+    std::visit(
+        [cnt, &m](auto& column) {
+            using T = std::decay_t<decltype(column[0])>;
+            column.resize(cnt);
+            const auto [first_chunk, end_chunk] = m.shard_chunks(column.chunk_count());
+            parallel_chunks(end_chunk - first_chunk, [&column, first_chunk](std::int64_t c) {
+                c += first_chunk;
+                auto* data       = column.chunk(c);
+                const auto first = c * column.chunk_elements;
+                const auto size  = column.chunk_size(c);
+                for (auto i = std::int64_t {0}; i < size; ++i)
+                    data[i] = static_cast<T>(first + i);
+            });
+        },
+        m.column(name, type));
+    return true;
+}
+
+// code variants of set_values
+static constexpr const char* add_values_variants[] = {"loop", "threads"};
+
+static void add_values_info(StepInfo& info) {
+    info.always_same_code = false;
+    info.variants         = add_values_variants;
+    info.shard            = ShardMode::elementwise;
+}
+
+static void add_values_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    const auto cnt  = conf.get_value(conf::add_values::cnt, std::int64_t {0});
+    const auto name = Model::column_name(conf);
+    const auto type = column_type(conf.get_string(conf::model::type, column_type_names[0]));
+
+    // an existing column keeps its type
+    info.model.columns.try_emplace(name, type);
+    info.model.elements[name] = std::max(cnt, std::int64_t {0});
+
+    if (info.model.lazy) {
+        // the consuming steps compute the elements
+        info.model.lazy_columns.insert_or_assign(
+            name, LazyCode {info.model.columns[name], std::max(cnt, std::int64_t {0}), {}});
+        code.push_back(Model::column_variable(name) + ".clear();");
+        return;
+    }
+
+    const auto data      = info.column(conf);
+    const auto data_type = info.column_type(conf);
+
+    if (cnt > 0) {
+        code.push_back("const auto cnt = " + std::to_string(cnt) + "LL;");
+        code.push_back(data + ".resize(cnt);");
+        if (info.variant == 1) {
+            info.includes.insert("<thread>");
+            info.includes.insert("<algorithm>");
+            code.push_back(
+                "const auto threads = std::max(1u, std::thread::hardware_concurrency());");
+            code.push_back("std::vector<std::thread> pool;");
+            code.push_back("for (auto t = 0u; t < threads; ++t) {");
+            code.push_back("\tpool.emplace_back([&" + data + ", t, threads]() {");
+            code.push_back("\t\tconst auto end = cnt * (t + 1) / threads;");
+            code.push_back("\t\tfor (auto i = cnt * t / threads; i < end; ++i) {" + data +
+                           "[i] = static_cast<" + data_type + ">(i);}");
+            code.push_back("\t});");
+            code.push_back("}");
+            code.push_back("for (auto& thread : pool) {thread.join();}");
+        } else {
+            code.push_back("for (auto i = 0LL; i < cnt; ++i) {" + data + "[i] = static_cast<" +
+                           data_type + ">(i);}");
+        }
+        info.needs_scope = true;
+    } else {
+        code.push_back(data + ".clear();");
+    }
+}
+
+// code variants of the reduction steps
+static constexpr const char* reduction_variants[] = {"loop", "unroll4", "unroll8", "threads"};
+
+static void reduction_info(StepInfo& info) {
+    info.always_same_code = true;
+    info.variants         = reduction_variants;
+    info.shard            = ShardMode::reduction;
+}
+
+static void sum_info(StepInfo& info) {
+    reduction_info(info);
+    info.combine = '+';
+}
+
+static void product_info(StepInfo& info) {
+    reduction_info(info);
+    info.combine = '*';
+}
+
+// creates the code of a reduction of the selected column into the selected result;
+// accumulates in double to stay exact for large numbers of elements
+static void reduction_code(
+    const Conf& conf, const char* init, const char* op, CodeLines& code, CodeInfo& info) {
+    const auto init_str = std::string(init);
+    const auto op_str   = std::string(op);
+    const auto column   = info.read_column(conf);
+    const auto data     = column._variable;
+    const auto res      = info.result(conf);
+
+    switch (info.variant) {
+    case 1:
+    case 2: {
+        // independent accumulators break the dependency chain of the loop
+        const auto acc = info.variant == 1 ? 4u : 8u;
+        const auto n   = std::to_string(acc);
+        code.push_back("double acc[" + n + "];");
+        code.push_back("for (auto& a : acc) {a = " + init_str + ";}");
+        code.push_back("const auto n = " + column.size() + ";");
+        code.push_back("auto i = std::size_t {0};");
+        code.push_back("for (; i + " + n + " <= n; i += " + n + ") {");
+        for (auto a = 0u; a < acc; ++a) {
+            const auto a_str = std::to_string(a);
+            code.push_back("\tacc[" + a_str + "] " + op_str + "= " + column.at("i + " + a_str) +
+                           ";");
+        }
+        code.push_back("}");
+        code.push_back("for (; i < n; ++i) {acc[0] " + op_str + "= " + column.at("i") + ";}");
+        code.push_back(res + " = " + init_str + ";");
+        code.push_back("for (const auto& a : acc) {" + res + " " + op_str + "= a;}");
+        info.needs_scope = true;
+        break;
+    }
+    case 3:
+        info.includes.insert("<thread>");
+        info.includes.insert("<algorithm>");
+        code.push_back("const auto threads = std::max(1u, std::thread::hardware_concurrency());");
+        code.push_back("const auto n = " + column.size() + ";");
+        code.push_back("std::vector<double> partial(threads, " + init_str + ");");
+        code.push_back("std::vector<std::thread> pool;");
+        code.push_back("for (auto t = 0u; t < threads; ++t) {");
+        code.push_back("\tpool.emplace_back([&" + data + ", &partial, n, t, threads]() {");
+        code.push_back("\t\tauto acc = " + init_str + ";");
+        code.push_back("\t\tconst auto end = n * (t + 1) / threads;");
+        code.push_back("\t\tfor (auto i = n * t / threads; i < end; ++i) {acc " + op_str + "= " +
+                       column.at("i") + ";}");
+        code.push_back("\t\tpartial[t] = acc;");
+        code.push_back("\t});");
+        code.push_back("}");
+        code.push_back("for (auto& thread : pool) {thread.join();}");
+        code.push_back(res + " = " + init_str + ";");
+        code.push_back("for (const auto& p : partial) {" + res + " " + op_str + "= p;}");
+        info.needs_scope = true;
+        break;
+    default:
+        code.push_back(res + " = " + init_str + ";");
+        if (column.lazy()) {
+            // fused with the steps producing the column
+            code.push_back("for (auto i = std::size_t {0}; i < " + column.size() + "; ++i) {" +
+                           res + " " + op_str + "= " + column.at("i") + ";}");
+        } else {
+            code.push_back("for (const auto&v:" + data + ") {" + res + " " + op_str + "= v;}");
+        }
+        break;
+    }
+}
+
+// elements per block of the parallel reductions; threads handle contiguous ranges of blocks
+// and the block results are combined in order, so the result doesn't depend on the thread count
+static constexpr std::int64_t reduce_block_elements = std::int64_t {1} << 16;
+
+// returns the number of reduction blocks of n elements
+static std::int64_t reduce_block_count(std::int64_t n) {
+    return (n + reduce_block_elements - 1) / reduce_block_elements;
+}
+
+// reduces the elements [first, last) of the column in parallel
+template <typename T, typename OP>
+static double reduce_elements(const ColumnView<T>& data,
+                              std::int64_t first,
+                              std::int64_t last,
+                              double init,
+                              OP op) {
+    std::vector<double> partial(reduce_block_count(last - first), init);
+    parallel_chunks(static_cast<std::int64_t>(partial.size()), [&](std::int64_t b) {
+        const auto begin = first + b * reduce_block_elements;
+        auto acc         = init;
+        data.range(begin,
+                   std::min(begin + reduce_block_elements, last),
+                   [&](const T* values, std::int64_t size) {
+                       for (auto i = std::int64_t {0}; i < size; ++i)
+                           acc = op(acc, static_cast<double>(values[i]));
+                   });
+        partial[b] = acc;
+    });
+
+    auto total = init;
+    for (const auto& p : partial)
+        total = op(total, p);
+    return total;
+}
+
+// reduces the shard of the selected column into the selected result
+template <typename OP> static void reduce_column(const Conf& conf, Model& m, double init, OP op) {
+    auto& res = m.result(Model::result_name(conf));
+    res       = init;
+    m.view_column(Model::column_name(conf), [&](const auto& data) {
+        const auto [first_chunk, end_chunk] = m.shard_chunks(data.chunk_count());
+        const auto first = first_chunk * data.chunk_elements;
+        const auto last  = std::min(end_chunk * data.chunk_elements, data.size());
+        res              = reduce_elements(data, first, last, init, op);
+    });
+}
+
+static auto calculate_sum(const Conf& conf, Model& m) {
+    reduce_column(conf, m, 0.0, std::plus<double> {});
+    return true;
+}
+
+static void calculate_sum_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    reduction_code(conf, "0.0", "+", code, info);
+}
+
+static auto print_value(const Conf& conf, Model& m) {
+    std::cout << "Result: " << m.result(Model::result_name(conf)) << "\n";
+    return true;
+}
+
+static void print_value_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    code.push_back("std::cout << \"Result: \" << " + info.result(conf) + " <<\"\\n\";");
+}
+
+static auto print_data(const Conf& conf, Model& m) {
+    std::cout << "Data:\n";
+    m.view_column(Model::column_name(conf), [](const auto& data) {
+        for (auto c = std::int64_t {0}; c < data.chunk_count(); ++c) {
+            data.blocks(c, [](const auto* values, std::int64_t size) {
+                for (auto i = std::int64_t {0}; i < size; ++i)
+                    std::cout << values[i] << "\n";
+            });
+        }
+    });
+    return true;
+}
+
+static void print_data_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    const auto column = info.read_column(conf);
+    code.push_back("std::cout << \"Data :\\n\";");
+    if (column.lazy()) {
+        code.push_back("for (auto i = std::size_t {0}; i < " + column.size() + "; ++i)");
+        code.push_back("\tstd::cout << " + column.at("i") + " << \"\\n\";");
+    } else {
+        code.push_back("for (const auto& v : " + column._variable + ")");
+        code.push_back("\tstd::cout << v << \"\\n\";");
+    }
+}
+
+// clears the selected column; clears all columns and results if none is selected
+static auto clear_values(const Conf& conf, Model& m) {
+    if (conf.contains(conf::model::column)) {
+        const auto name = Model::column_name(conf);
+        if (auto* lazy = m.find_lazy(name))
+            lazy->_size = 0;
+        else if (auto* column = m.find_column(name))
+            std::visit([](auto& data) { data.clear(); }, *column);
+        return true;
+    }
+
+    for (auto& [name, lazy] : m._lazy)
+        lazy._size = 0;
+    for (auto& [name, column] : m._columns)
+        std::visit([](auto& data) { data.clear(); }, column);
+    for (auto& [name, res] : m._results)
+        res = 0.0;
+    return true;
+}
+
+static void clear_values_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    if (conf.contains(conf::model::column)) {
+        const auto name = Model::column_name(conf);
+        info.model.columns.try_emplace(name, 0);
+        info.model.lazy_columns.erase(name);
+        info.model.elements[name] = 0;
+        code.push_back(Model::column_variable(name) + ".clear();");
+        return;
+    }
+
+    info.model.lazy_columns.clear();
+    for (const auto& [name, type] : info.model.columns) {
+        info.model.elements[name] = 0;
+        code.push_back(Model::column_variable(name) + ".clear();");
+    }
+    for (const auto& name : info.model.results)
+        code.push_back(Model::result_variable(name) + " = 0.0;");
+}
+
+namespace conf {
+    namespace transform {
+        KEY(value)
+    }
+} // namespace conf
+
+// applies op with value to each element of the selected column; only recorded for a lazy column
+static auto transform_values(const Conf& conf, Model& m, char op, double value) {
+    const auto name = Model::column_name(conf);
+    if (auto* lazy = m.find_lazy(name)) {
+        lazy->_ops.push_back({op, value});
+        return true;
+    }
+
+    auto* column = m.find_column(name);
+    if (column == nullptr)
+        return true;
+
+    std::visit(
+        [op, value, &m](auto& data) {
+            using T = std::decay_t<decltype(data[0])>;
+            const auto [first_chunk, end_chunk] = m.shard_chunks(data.chunk_count());
+            const auto chunks                   = end_chunk - first_chunk;
+            parallel_chunks(chunks, [&data, op, value, first_chunk](std::int64_t c) {
+                c += first_chunk;
+                auto* values    = data.chunk(c);
+                const auto size = data.chunk_size(c);
+                if (op == '*')
+                    for (auto i = std::int64_t {0}; i < size; ++i)
+                        values[i] = static_cast<T>(values[i] * value);
+                else
+                    for (auto i = std::int64_t {0}; i < size; ++i)
+                        values[i] = static_cast<T>(values[i] + value);
+            });
+        },
+        *column);
+    return true;
+}
+
+static void
+transform_code(const Conf& conf, char op, double value, CodeLines& code, CodeInfo& info) {
+    const auto name = Model::column_name(conf);
+    info.model.columns.try_emplace(name, 0);
+
+    auto lazy = info.model.lazy_columns.find(name);
+    if (lazy != info.model.lazy_columns.end()) {
+        lazy->second.ops.push_back({op, value});
+        code.push_back("// fused into the steps reading " + Model::column_variable(name));
+        return;
+    }
+
+    const auto data = info.column(conf);
+    code.push_back("for (auto& v : " + data + ") {v = static_cast<" + info.column_type(conf) +
+                   ">(v " + op + " " + double_literal(value) + ");}");
+}
+
+static void transform_info(StepInfo& info) {
+    info.always_same_code = false;
+    info.shard            = ShardMode::elementwise;
+}
+
+static auto scale_values(const Conf& conf, Model& m) {
+    return transform_values(conf, m, '*', conf.get_value(conf::transform::value, 1.0));
+}
+
+static void scale_values_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    transform_code(conf, '*', conf.get_value(conf::transform::value, 1.0), code, info);
+}
+
+static auto offset_values(const Conf& conf, Model& m) {
+    return transform_values(conf, m, '+', conf.get_value(conf::transform::value, 0.0));
+}
+
+static void offset_values_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    transform_code(conf, '+', conf.get_value(conf::transform::value, 0.0), code, info);
+}
+
+static auto calculate_product(const Conf& conf, Model& m) {
+    reduce_column(conf, m, 1.0, std::multiplies<double> {});
+    return true;
+}
+
+static void calculate_product_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    reduction_code(conf, "1.0", "*", code, info);
+}
+
+static auto check_value(const Conf& conf, Model& m) {
+    const auto ref = conf.get_value(conf::check_value::ref, 0.0);
+    return ref == m.result(Model::result_name(conf));
+}
+
+static void check_value_info(StepInfo& info) {
     info.always_same_code = false;
+    info.returns_stop     = true;
+    info.stop_variable    = "res_ok";
+}
+
+static void check_value_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    const auto ref    = conf.get_value(conf::check_value::ref, 0.0);
+    const auto refStr = double_literal(ref);
+    code.push_back("const auto expected_value = " + refStr + ";");
+    code.push_back("const auto res_ok = expected_value == " + info.result(conf) + ";");
+    info.needs_scope = true;
+}
+
+static auto check_data(const Conf& conf, Model& m) {
+    auto populated = false;
+    m.view_column(Model::column_name(conf),
+                  [&populated](const auto& data) { populated = data.size() > 0; });
+    return populated;
+}
+
+static void check_data_info(StepInfo& info) {
+    info.always_same_code = true;
+    info.returns_stop     = true;
+    info.stop_variable    = "populated";
 }
 
-static void print_number_code(const Conf& conf, CodeLines& code, CodeInfo&) {
-    const auto say    = conf.get_value(conf::print_number::num, .0f);
-    const auto sayStr = std::to_string(say);
-    code.push_back("std::cout<<\"Number: \"<<" + sayStr + "<<\"\\n\";");
+static void check_data_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    code.push_back("const auto populated = !" + info.read_column(conf).empty() + ";");
+    info.needs_scope = true;
 }
 
-static auto add_values(const Conf& conf, Model& m) {
-    const auto cnt = conf.get_value(conf::add_values::cnt, 0);
-    m._data.resize(cnt);
-    for (auto i = 0; i < cnt; ++i)
-        m._data[i] = static_cast<float>(i);
-    return true;
-}
+namespace conf {
+    namespace reduce {
+        KEY(sum)
+        KEY(product)
+        KEY(min)
+        KEY(max)
+        KEY(mean)
+        KEY(variance)
+        KEY(count)
+        KEY(threads)
+        KEY(prefix)
+    }
+} // namespace conf
 
-static void add_values_info(StepInfo& info) {
-    info.always_same_code = false;
+// statistics computed by the reduce step; the result slot is "<prefix>_<name>"
+static constexpr const char* reduce_statistics[] = {
+    conf::reduce::sum,
+    conf::reduce::product,
+    conf::reduce::min,
+    conf::reduce::max,
+    conf::reduce::mean,
+    conf::reduce::variance,
+    conf::reduce::count,
+};
+
+// statistics requested from the reduce step
+struct ReduceRequest {
+    std::array<bool, std::size(reduce_statistics)> _stats {};
+    std::string _prefix;
+
+    // reads the request from the Conf; requests all statistics if none is selected
+    explicit ReduceRequest(const Conf& conf) {
+        auto any = false;
+        for (auto s = 0u; s < _stats.size(); ++s) {
+            _stats[s] = conf.get_value(reduce_statistics[s], std::int64_t {0}) != 0;
+            any |= _stats[s];
+        }
+        if (!any)
+            _stats.fill(true);
+        _prefix = conf.get_string(conf::reduce::prefix, Model::column_name(conf).c_str());
+    }
+
+    auto wants(unsigned int s) const {
+        return _stats[s];
+    }
+    auto product() const {
+        return _stats[1];
+    }
+    auto min_max() const {
+        return _stats[2] || _stats[3];
+    }
+    auto moments() const {
+        return _stats[5];
+    }
+
+    // returns the result slot of the statistic
+    std::string result(unsigned int s) const {
+        return _prefix + "_" + reduce_statistics[s];
+    }
+};
+
+// partial statistics of a range of elements
+struct Moments {
+    std::int64_t _count = 0;
+    double _sum         = 0.0;
+    double _product     = 1.0;
+    double _min         = std::numeric_limits<double>::infinity();
+    double _max         = -std::numeric_limits<double>::infinity();
+    double _mean        = 0.0;
+    // sum of squared deviations from the mean
+    double _m2 = 0.0;
+
+    // adds the statistics of another range (Chan et al.)
+    void combine(const Moments& other) {
+        if (other._count == 0)
+            return;
+
+        const auto count = _count + other._count;
+        const auto delta = other._mean - _mean;
+        _mean += delta * static_cast<double>(other._count) / static_cast<double>(count);
+        _m2 += other._m2 + delta * delta * static_cast<double>(_count) *
+                               static_cast<double>(other._count) / static_cast<double>(count);
+        _count = count;
+        _sum += other._sum;
+        _product *= other._product;
+        _min = std::min(_min, other._min);
+        _max = std::max(_max, other._max);
+    }
+};
+
+// computes the statistics of n values in one pass; independent lanes let the compiler vectorize
+template <bool PRODUCT, bool MIN_MAX, bool MOMENTS, typename T>
+static Moments reduce_range(const T* values, std::int64_t n) {
+    constexpr auto lanes = 8;
+
+    Moments res;
+    if (n <= 0)
+        return res;
+
+    // deviations from the first value keep the sum of squares small
+    const auto shift = static_cast<double>(values[0]);
+
+    std::array<double, lanes> sum {}, dev {}, sq {};
+    std::array<double, lanes> product, min, max;
+    product.fill(1.0);
+    min.fill(res._min);
+    max.fill(res._max);
+
+    auto add = [&](unsigned int l, double x) {
+        sum[l] += x;
+        if constexpr (PRODUCT)
+            product[l] *= x;
+        if constexpr (MIN_MAX) {
+            min[l] = x < min[l] ? x : min[l];
+            max[l] = x > max[l] ? x : max[l];
+        }
+        if constexpr (MOMENTS) {
+            const auto d = x - shift;
+            dev[l] += d;
+            sq[l] += d * d;
+        }
+    };
+
+    auto i = std::int64_t {0};
+    for (; i + lanes <= n; i += lanes)
+        for (auto l = 0u; l < lanes; ++l)
+            add(l, static_cast<double>(values[i + l]));
+    for (; i < n; ++i)
+        add(0, static_cast<double>(values[i]));
+
+    auto d = 0.0, s = 0.0;
+    for (auto l = 0u; l < lanes; ++l) {
+        res._sum += sum[l];
+        res._product *= product[l];
+        res._min = std::min(res._min, min[l]);
+        res._max = std::max(res._max, max[l]);
+        d += dev[l];
+        s += sq[l];
+    }
+
+    const auto count = static_cast<double>(n);
+    res._count       = n;
+    res._mean        = res._sum / count;
+    res._m2          = std::max(s - d * d / count, 0.0);
+    return res;
 }
 
-static void add_values_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
-    const auto cnt = conf.get_value(conf::add_values::cnt, 0);
-    if (cnt > 0) {
-        code.push_back("const auto cnt = " + std::to_string(cnt) + ";");
-        code.push_back("data.resize(cnt);");
-        code.push_back("for (auto i = 0; i < cnt; ++i) {data[i] = static_cast<float>(i);}");
-        info.needs_scope = true;
-    } else {
-        code.push_back("data.clear();");
+// picks the instance of reduce_range computing the requested statistics
+template <typename T>
+static Moments reduce_range(const ReduceRequest& req, const T* values, std::int64_t n) {
+    switch ((req.product() ? 4 : 0) | (req.min_max() ? 2 : 0) | (req.moments() ? 1 : 0)) {
+    case 0:
+        return reduce_range<false, false, false>(values, n);
+    case 1:
+        return reduce_range<false, false, true>(values, n);
+    case 2:
+        return reduce_range<false, true, false>(values, n);
+    case 3:
+        return reduce_range<false, true, true>(values, n);
+    case 4:
+        return reduce_range<true, false, false>(values, n);
+    case 5:
+        return reduce_range<true, false, true>(values, n);
+    case 6:
+        return reduce_range<true, true, false>(values, n);
+    default:
+        return reduce_range<true, true, true>(values, n);
     }
 }
 
-static auto calculate_sum(const Conf&, Model& m) {
-    m._res = 0.0f;
-    for (const auto& v : m._data)
-        m._res += v;
+// computes the requested statistics of the selected column in a single pass
+static auto reduce(const Conf& conf, Model& m) {
+    const ReduceRequest req {conf};
+    const auto threads = conf.get_value(conf::reduce::threads, std::int64_t {0});
+
+    Moments total;
+    m.view_column(Model::column_name(conf), [&](const auto& data) {
+        const auto n = data.size();
+        std::vector<Moments> partial(reduce_block_count(n));
+        parallel_chunks(
+            static_cast<std::int64_t>(partial.size()),
+            [&](std::int64_t b) {
+                const auto first = b * reduce_block_elements;
+                const auto last  = std::min(first + reduce_block_elements, n);
+                data.range(first, last, [&](const auto* values, std::int64_t size) {
+                    partial[b].combine(reduce_range(req, values, size));
+                });
+            },
+            threads);
+        // combined in block order, so the result doesn't depend on the thread count
+        for (const auto& p : partial)
+            total.combine(p);
+    });
+
+    const auto count          = static_cast<double>(total._count);
+    const double values[]     = {total._sum,
+                                 total._product,
+                                 total._min,
+                                 total._max,
+                                 total._mean,
+                                 total._count > 0 ? total._m2 / count : 0.0,
+                                 count};
+    for (auto s = 0u; s < std::size(reduce_statistics); ++s)
+        if (req.wants(s))
+            m.result(req.result(s)) = values[s];
     return true;
 }
 
-static void calculate_sum_code(const Conf&, CodeLines& code, CodeInfo&) {
-    code.push_back("res = 0.0f;");
-    code.push_back("for (const auto&v:data) {res += v;}");
-}
+// code variants of reduce
+static constexpr const char* reduce_variants[] = {"loop", "threads"};
 
-static auto print_value(const Conf&, Model& m) {
-    std::cout << "Result: " << m._res << "\n";
-    return true;
+static void reduce_info(StepInfo& info) {
+    info.always_same_code = false;
+    info.variants         = reduce_variants;
 }
 
-static void print_value_code(const Conf&, CodeLines& code, CodeInfo&) {
-    code.push_back("std::cout << \"Result: \" << res <<\"\\n\";");
+static void reduce_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    const ReduceRequest req {conf};
+    const auto column  = info.read_column(conf);
+    const auto data    = column._variable;
+    const auto threads = conf.get_value(conf::reduce::threads, std::int64_t {0});
+
+    info.includes.insert("<limits>");
+    info.needs_scope = true;
+
+    // accumulates element i of data into the local statistics
+    auto accumulate = [&](const std::string& tabs) {
+        code.push_back(tabs + "const auto x = static_cast<double>(" + column.at("i") + ");");
+        code.push_back(tabs + "sum += x;");
+        if (req.product())
+            code.push_back(tabs + "product *= x;");
+        if (req.min_max()) {
+            code.push_back(tabs + "lo = x < lo ? x : lo;");
+            code.push_back(tabs + "hi = x > hi ? x : hi;");
+        }
+        if (req.moments()) {
+            code.push_back(tabs + "const auto d = x - shift;");
+            code.push_back(tabs + "dev += d;");
+            code.push_back(tabs + "sq += d * d;");
+        }
+    };
+
+    // declares the local statistics of the range [begin, end)
+    auto declare = [&](const std::string& tabs, const std::string& begin, const std::string& end) {
+        code.push_back(tabs + "auto sum = 0.0;");
+        if (req.product())
+            code.push_back(tabs + "auto product = 1.0;");
+        if (req.min_max())
+            code.push_back(tabs + "auto lo = std::numeric_limits<double>::infinity(), hi = -lo;");
+        if (req.moments()) {
+            code.push_back(tabs + "auto dev = 0.0, sq = 0.0;");
+            code.push_back(tabs + "const auto shift = " + begin + " < " + end +
+                           " ? static_cast<double>(" + column.at(begin) + ") : 0.0;");
+        }
+    };
+
+    code.push_back("const auto n = " + column.size() + ";");
+
+    if (info.variant == 1) {
+        info.includes.insert("<thread>");
+        info.includes.insert("<algorithm>");
+        if (threads > 0)
+            code.push_back("const auto threads = " + std::to_string(threads) + "u;");
+        else
+            code.push_back(
+                "const auto threads = std::max(1u, std::thread::hardware_concurrency());");
+
+        code.push_back("struct Partial {");
+        code.push_back("\tdouble count = 0.0, sum = 0.0, product = 1.0, mean = 0.0, m2 = 0.0;");
+        code.push_back("\tdouble lo = std::numeric_limits<double>::infinity(), hi = -lo;");
+        code.push_back("};");
+        code.push_back("std::vector<Partial> partial(threads);");
+        code.push_back("std::vector<std::thread> pool;");
+        code.push_back("for (auto t = 0u; t < threads; ++t) {");
+        code.push_back("\tpool.emplace_back([&" + data + ", &partial, n, t, threads]() {");
+        code.push_back("\t\tconst auto begin = n * t / threads;");
+        code.push_back("\t\tconst auto end = n * (t + 1) / threads;");
+        declare("\t\t", "begin", "end");
+        code.push_back("\t\tfor (auto i = begin; i < end; ++i) {");
+        accumulate("\t\t\t");
+        code.push_back("\t\t}");
+        code.push_back("\t\tauto& p = partial[t];");
+        code.push_back("\t\tp.count = static_cast<double>(end - begin);");
+        code.push_back("\t\tp.sum = sum;");
+        code.push_back("\t\tp.mean = p.count > 0 ? sum / p.count : 0.0;");
+        if (req.product())
+            code.push_back("\t\tp.product = product;");
+        if (req.min_max()) {
+            code.push_back("\t\tp.lo = lo;");
+            code.push_back("\t\tp.hi = hi;");
+        }
+        if (req.moments())
+            code.push_back("\t\tp.m2 = p.count > 0 ? sq - dev * dev / p.count : 0.0;");
+        code.push_back("\t});");
+        code.push_back("}");
+        code.push_back("for (auto& thread : pool) {thread.join();}");
+        code.push_back("Partial total;");
+        code.push_back("for (const auto& p : partial) {");
+        code.push_back("\tif (p.count == 0.0) {continue;}");
+        code.push_back("\tconst auto count = total.count + p.count;");
+        code.push_back("\tconst auto delta = p.mean - total.mean;");
+        code.push_back("\ttotal.mean += delta * p.count / count;");
+        code.push_back("\ttotal.m2 += p.m2 + delta * delta * total.count * p.count / count;");
+        code.push_back("\ttotal.count = count;");
+        code.push_back("\ttotal.sum += p.sum;");
+        code.push_back("\ttotal.product *= p.product;");
+        code.push_back("\ttotal.lo = std::min(total.lo, p.lo);");
+        code.push_back("\ttotal.hi = std::max(total.hi, p.hi);");
+        code.push_back("}");
+    } else {
+        declare("", "0", "n");
+        code.push_back("for (auto i = std::size_t {0}; i < n; ++i) {");
+        accumulate("\t");
+        code.push_back("}");
+    }
+
+    // the threaded variant reads the combined statistics
+    const auto combined = info.variant == 1;
+    const std::string values[] = {
+        combined ? "total.sum" : "sum",
+        combined ? "total.product" : "product",
+        combined ? "total.lo" : "lo",
+        combined ? "total.hi" : "hi",
+        combined ? "total.mean" : "n > 0 ? sum / n : 0.0",
+        combined ? "n > 0 ? total.m2 / n : 0.0" : "n > 0 ? (sq - dev * dev / n) / n : 0.0",
+        "static_cast<double>(n)"};
+    for (auto s = 0u; s < std::size(reduce_statistics); ++s) {
+        if (!req.wants(s))
+            continue;
+        const auto name = req.result(s);
+        info.model.results.insert(name);
+        code.push_back(Model::result_variable(name) + " = " + values[s] + ";");
+    }
 }
 
-static auto print_data(const Conf&, Model& m) {
-    std::cout << "Data:\n";
-    for (const auto& v : m._data)
-        std::cout << v << "\n";
-    return true;
+// returns the number of threads for n elements; requested threads if above 0, else thread_limit()
+// small inputs get fewer threads, so starting threads doesn't cost more than it saves
+static std::int64_t thread_count(std::int64_t requested, std::int64_t n) {
+    constexpr auto min_elements = std::int64_t {1} << 16;
+    const auto limit   = thread_limit();
+    const auto threads = requested > 0 ? std::min(requested, limit) : limit;
+    return std::clamp(n / min_elements, std::int64_t {1}, threads);
 }
 
-static void print_data_code(const Conf&, CodeLines& code, CodeInfo&) {
-    code.push_back("std::cout << \"Data :\\n\";");
-    code.push_back("for (const auto& v : data)");
-    code.push_back("\tstd::cout << v << \"\\n\";");
+namespace conf {
+    namespace sort {
+        KEY(threads)
+    }
+} // namespace conf
+
+// unsigned key of an element; keys compare like the elements
+template <typename T> struct RadixKey {
+    using Key                = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+    static constexpr Key sign = Key {1} << (sizeof(Key) * 8 - 1);
+
+    static Key encode(T value) {
+        const auto bits = std::bit_cast<Key>(value);
+        if constexpr (std::is_floating_point_v<T>)
+            return bits & sign ? ~bits : bits | sign;
+        else
+            return bits ^ sign;
+    }
+};
+
+// sorts the elements by the 8-bit digits of their keys, least significant first
+// tmp is scratch memory of the size of data, so no contiguous copy of a large column is needed
+// each pass counts the digits of the range of every thread, then every thread scatters its range;
+// the elements are collected in a buffer per digit, so a thread writes several cache lines at once
+template <typename T>
+static void radix_sort(ChunkedArray<T>& data, ChunkedArray<T>& tmp, std::int64_t threads) {
+    using Key               = typename RadixKey<T>::Key;
+    constexpr auto radix    = 256;
+    constexpr auto buffered = static_cast<int>(4 * data_alignment / sizeof(T));
+
+    const auto n = data.size();
+    std::vector<std::array<std::int64_t, radix>> next(threads);
+
+    // the passes alternate between the arrays
+    auto* from = &data;
+    auto* to   = &tmp;
+
+    for (auto shift = 0u; shift < sizeof(Key) * 8; shift += 8) {
+        const auto digit = [shift](T value) {
+            return (RadixKey<T>::encode(value) >> shift) & (radix - 1);
+        };
+
+        parallel_chunks(
+            threads,
+            [&](std::int64_t t) {
+                auto& count = next[t];
+                count.fill(0);
+                from->pieces(n * t / threads,
+                             n * (t + 1) / threads,
+                             [&](const T* values, std::int64_t size) {
+                                 for (auto i = std::int64_t {0}; i < size; ++i)
+                                     ++count[digit(values[i])];
+                             });
+            },
+            threads);
+
+        // digit-major, thread-minor offsets keep equal digits in the order of the previous pass
+        auto offset = std::int64_t {0};
+        auto single = false;
+        for (auto d = 0; d < radix; ++d) {
+            const auto first = offset;
+            for (auto& count : next) {
+                const auto c = count[d];
+                count[d]     = offset;
+                offset += c;
+            }
+            single |= offset - first == n;
+        }
+        // all keys have the same digit; the pass keeps the order
+        if (single)
+            continue;
+
+        parallel_chunks(
+            threads,
+            [&](std::int64_t t) {
+                auto& target = next[t];
+                alignas(data_alignment) T buffer[radix][buffered];
+                int fill[radix] = {};
+                from->pieces(n * t / threads,
+                             n * (t + 1) / threads,
+                             [&](const T* values, std::int64_t size) {
+                                 for (auto i = std::int64_t {0}; i < size; ++i) {
+                                     const auto value = values[i];
+                                     const auto d     = digit(value);
+                                     const auto f     = fill[d];
+                                     buffer[d][f]     = value;
+                                     if (f + 1 < buffered) {
+                                         fill[d] = f + 1;
+                                         continue;
+                                     }
+                                     // fixed size, so the copy is a few vector moves
+                                     to->write(target[d], buffer[d], buffered);
+                                     target[d] += buffered;
+                                     fill[d] = 0;
+                                 }
+                             });
+                for (auto d = 0; d < radix; ++d)
+                    to->write(target[d], buffer[d], fill[d]);
+            },
+            threads);
+        std::swap(from, to);
+    }
+
+    // an odd number of passes left the elements in tmp
+    if (from != &data)
+        parallel_chunks(
+            data.chunk_count(),
+            [&](std::int64_t c) { std::copy_n(tmp.chunk(c), tmp.chunk_size(c), data.chunk(c)); },
+            threads);
 }
 
-static auto clear_values(const Conf&, Model& m) {
-    m._data.clear();
-    m._res = .0f;
+// sorts the elements of the selected column in ascending order with a radix sort
+static auto sort_values(const Conf& conf, Model& m) {
+    auto* column = m.find_column(Model::column_name(conf));
+    if (column == nullptr)
+        return true;
+
+    std::visit(
+        [&conf, &m](auto& data) {
+            using T = std::decay_t<decltype(data[0])>;
+
+            const auto threads =
+                thread_count(conf.get_value(conf::sort::threads, std::int64_t {0}), data.size());
+            // sorted in place with one chunked scratch array allocated like the columns
+            ChunkedArray<T> tmp {m._memory};
+            tmp.resize(data.size());
+            radix_sort(data, tmp, threads);
+        },
+        *column);
     return true;
 }
 
-static void clear_values_code(const Conf&, CodeLines& code, CodeInfo&) {
-    code.push_back("data.clear();");
-    code.push_back("res = 0.0f;");
-}
+// code variants of sort
+static constexpr const char* sort_variants[] = {"radix", "std"};
 
-static auto calculate_product(const Conf&, Model& m) {
-    m._res = 1.0f;
-    for (const auto& v : m._data)
-        m._res *= v;
-    return true;
+static void sort_info(StepInfo& info) {
+    info.always_same_code = true;
+    info.variants         = sort_variants;
+    info.tune_shuffled    = true;
 }
 
-static void calculate_product_code(const Conf&, CodeLines& code, CodeInfo&) {
-    code.push_back("res = 1.0f;");
-    code.push_back("for (const auto&v:data) {res *= v;}");
+static void sort_values_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    const auto data = info.column(conf);
+    const auto type = info.model.columns[Model::column_name(conf)];
+
+    if (info.variant == 1) {
+        info.includes.insert("<algorithm>");
+        code.push_back("std::sort(" + data + ".begin(), " + data + ".end());");
+        return;
+    }
+
+    // keys compare like the elements; floats are mapped by their sign
+    const auto floating = type <= 1;
+    info.includes.insert("<cstdint>");
+    info.includes.insert("<cstring>");
+    info.needs_scope = true;
+    code.push_back(std::string {"using Key = "} +
+                   (type % 2 == 0 ? "std::uint32_t;" : "std::uint64_t;"));
+    code.push_back("constexpr auto sign = Key {1} << (sizeof(Key) * 8 - 1);");
+    code.push_back("std::vector<Key> keys(" + data + ".size()), tmp(" + data + ".size());");
+    code.push_back("for (auto i = std::size_t {0}; i < keys.size(); ++i) {");
+    code.push_back("\tKey k;");
+    code.push_back("\tstd::memcpy(&k, &" + data + "[i], sizeof(k));");
+    code.push_back(floating ? "\tkeys[i] = k & sign ? ~k : k | sign;" : "\tkeys[i] = k ^ sign;");
+    code.push_back("}");
+    code.push_back("for (auto shift = 0u; shift < sizeof(Key) * 8; shift += 8) {");
+    code.push_back("\tstd::size_t count[257] = {};");
+    code.push_back("\tfor (const auto k : keys) {++count[((k >> shift) & 255) + 1];}");
+    code.push_back("\tfor (auto d = 0; d < 256; ++d) {count[d + 1] += count[d];}");
+    code.push_back("\tfor (const auto k : keys) {tmp[count[(k >> shift) & 255]++] = k;}");
+    code.push_back("\tkeys.swap(tmp);");
+    code.push_back("}");
+    code.push_back("for (auto i = std::size_t {0}; i < keys.size(); ++i) {");
+    code.push_back(floating ? "\tconst Key k = keys[i] & sign ? keys[i] & ~sign : ~keys[i];"
+                            : "\tconst Key k = keys[i] ^ sign;");
+    code.push_back("\tstd::memcpy(&" + data + "[i], &k, sizeof(k));");
+    code.push_back("}");
 }
 
-static auto check_value(const Conf& conf, Model& m) {
-    const auto ref = conf.get_value(conf::check_value::ref, 0.0f);
-    return ref == m._res;
+namespace conf {
+    namespace scan {
+        KEY(exclusive)
+        KEY(threads)
+    }
+} // namespace conf
+
+// replaces each element of the selected column by the sum of the elements before it,
+// including the element unless exclusive is set; sums are accumulated in double
+// the chunks are summed in parallel, then every chunk is scanned from the sum of the chunks before
+static auto scan_values(const Conf& conf, Model& m) {
+    auto* column = m.find_column(Model::column_name(conf));
+    if (column == nullptr)
+        return true;
+
+    const auto exclusive = conf.get_value(conf::scan::exclusive, std::int64_t {0}) != 0;
+    const auto threads   = conf.get_value(conf::scan::threads, std::int64_t {0});
+
+    std::visit(
+        [exclusive, threads](auto& data) {
+            using T = std::decay_t<decltype(data[0])>;
+
+            // scans the elements first to last starting at the given sum; returns the sum after
+            const auto scan_range = [&data, exclusive](std::int64_t first,
+                                                       std::int64_t last,
+                                                       double acc) {
+                data.pieces(first, last, [&acc, exclusive](T* values, std::int64_t size) {
+                    if (exclusive) {
+                        for (auto i = std::int64_t {0}; i < size; ++i) {
+                            const auto x = values[i];
+                            values[i]    = static_cast<T>(acc);
+                            acc += x;
+                        }
+                    } else {
+                        for (auto i = std::int64_t {0}; i < size; ++i) {
+                            acc += values[i];
+                            values[i] = static_cast<T>(acc);
+                        }
+                    }
+                });
+                return acc;
+            };
+
+            // a single thread reads the data only once
+            const auto n       = data.size();
+            const auto workers = thread_count(threads, n);
+            if (workers == 1) {
+                scan_range(0, n, 0.0);
+                return;
+            }
+
+            // every thread sums its range, then scans it starting at the sum of the ranges before
+            std::vector<double> offset(workers + 1, 0.0);
+            parallel_chunks(
+                workers,
+                [&](std::int64_t t) {
+                    const auto first = n * t / workers;
+                    const auto last  = n * (t + 1) / workers;
+                    data.pieces(first, last, [&](const T* values, std::int64_t size) {
+                        offset[t + 1] += reduce_range<false, false, false>(values, size)._sum;
+                    });
+                },
+                workers);
+            for (auto t = std::int64_t {0}; t < workers; ++t)
+                offset[t + 1] += offset[t];
+
+            parallel_chunks(
+                workers,
+                [&](std::int64_t t) {
+                    scan_range(n * t / workers, n * (t + 1) / workers, offset[t]);
+                },
+                workers);
+        },
+        *column);
+    return true;
 }
 
-static void check_value_info(StepInfo& info) {
+static void scan_info(StepInfo& info) {
     info.always_same_code = false;
-    info.returns_stop     = true;
-    info.stop_variable    = "res_ok";
 }
 
-static void check_value_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
-    const auto ref    = conf.get_value(conf::check_value::ref, 0.0f);
-    const auto refStr = std::to_string(ref);
-    code.push_back("const auto expected_value = " + refStr + "f;");
-    code.push_back("const auto res_ok = expected_value == res;");
+static void scan_values_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    const auto data = info.column(conf);
+    const auto type = info.column_type(conf);
+
+    code.push_back("auto acc = 0.0;");
+    if (conf.get_value(conf::scan::exclusive, std::int64_t {0}) != 0)
+        code.push_back("for (auto& v : " + data + ") {const auto x = v; v = static_cast<" + type +
+                       ">(acc); acc += x;}");
+    else
+        code.push_back("for (auto& v : " + data + ") {acc += v; v = static_cast<" + type +
+                       ">(acc);}");
     info.needs_scope = true;
 }
 
-static auto check_data(const Conf&, Model& m) {
-    return !m._data.empty();
+namespace conf {
+    namespace histogram {
+        KEY(bins)
+        KEY(min)
+        KEY(max)
+        KEY(output)
+        KEY(threads)
+    }
+} // namespace conf
+
+// returns the column storing the histogram of the selected column
+static std::string histogram_output(const Conf& conf) {
+    const auto name = Model::column_name(conf) + "_histogram";
+    return conf.get_string(conf::histogram::output, name.c_str());
 }
 
-static void check_data_info(StepInfo& info) {
-    info.always_same_code = true;
-    info.returns_stop     = true;
-    info.stop_variable    = "populated";
+// counts the elements of the selected column in bins of equal width over [min, max]; uses the range
+// of the elements if max isn't above min; elements outside the range are not counted
+// the counts are stored in the output column, which is created as i64
+static auto histogram(const Conf& conf, Model& m) {
+    const auto bins =
+        std::max(conf.get_value(conf::histogram::bins, std::int64_t {16}), std::int64_t {1});
+    auto lo         = conf.get_value(conf::histogram::min, 0.0);
+    auto hi         = conf.get_value(conf::histogram::max, 0.0);
+
+    // the last count collects the elements outside the range, so counting doesn't branch
+    std::vector<std::int64_t> counts(bins + 1, 0);
+
+    m.view_column(Model::column_name(conf), [&](const auto& data) {
+        // every thread handles a contiguous range of the elements
+        const auto n       = data.size();
+        const auto threads =
+            thread_count(conf.get_value(conf::histogram::threads, std::int64_t {0}), n);
+
+        if (hi <= lo) {
+            std::vector<Moments> partial(threads);
+            parallel_chunks(
+                threads,
+                [&](std::int64_t t) {
+                    const auto first = n * t / threads;
+                    const auto last  = n * (t + 1) / threads;
+                    data.range(first, last, [&](const auto* values, std::int64_t size) {
+                        partial[t].combine(reduce_range<false, true, false>(values, size));
+                    });
+                },
+                threads);
+            Moments range;
+            for (const auto& p : partial)
+                range.combine(p);
+            lo = range._min;
+            hi = range._max;
+        }
+
+        const auto scale = hi > lo ? static_cast<double>(bins) / (hi - lo) : 0.0;
+
+        // every thread counts into its own bins
+        std::vector<std::vector<std::int64_t>> partial(threads,
+                                                       std::vector<std::int64_t>(bins + 1, 0));
+        parallel_chunks(
+            threads,
+            [&](std::int64_t t) {
+                const auto last  = bins - 1;
+                const auto first = n * t / threads;
+                const auto end   = n * (t + 1) / threads;
+                auto& count      = partial[t];
+                data.range(first, end, [&](const auto* values, std::int64_t size) {
+                    for (auto i = std::int64_t {0}; i < size; ++i) {
+                        const auto x = static_cast<double>(values[i]);
+                        ++count[x >= lo && x <= hi
+                                    ? std::min(static_cast<std::int64_t>((x - lo) * scale), last)
+                                    : bins];
+                    }
+                });
+            },
+            threads);
+
+        for (const auto& p : partial)
+            for (auto b = std::int64_t {0}; b < bins; ++b)
+                counts[b] += p[b];
+    });
+
+    // an existing column keeps its type
+    std::visit(
+        [&counts, bins](auto& data) {
+            using T = std::decay_t<decltype(data[0])>;
+            data.resize(bins);
+            for (auto b = std::int64_t {0}; b < bins; ++b)
+                data[b] = static_cast<T>(counts[b]);
+        },
+        m.column(histogram_output(conf), 3));
+    return true;
+}
+
+static void histogram_info(StepInfo& info) {
+    info.always_same_code = false;
 }
 
-static void check_data_code(const Conf&, CodeLines& code, CodeInfo& info) {
-    code.push_back("const auto populated = !data.empty();");
+static void histogram_code(const Conf& conf, CodeLines& code, CodeInfo& info) {
+    const auto bins =
+        std::max(conf.get_value(conf::histogram::bins, std::int64_t {16}), std::int64_t {1});
+    const auto lo     = conf.get_value(conf::histogram::min, 0.0);
+    const auto hi     = conf.get_value(conf::histogram::max, 0.0);
+    const auto column = info.read_column(conf);
+
+    const auto output = histogram_output(conf);
+    info.model.columns.try_emplace(output, 3);
+    info.model.lazy_columns.erase(output);
+    info.model.elements[output] = bins;
+    const auto out      = Model::column_variable(output);
+    const auto out_type = column_code_types[info.model.columns[output]];
+
+    info.includes.insert("<algorithm>");
+    info.includes.insert("<cstdint>");
     info.needs_scope = true;
+
+    code.push_back("const auto n = " + column.size() + ";");
+    if (hi > lo) {
+        code.push_back("const auto lo = " + double_literal(lo) + ", hi = " + double_literal(hi) +
+                       ";");
+    } else {
+        // the range of the elements
+        info.includes.insert("<limits>");
+        code.push_back("auto lo = std::numeric_limits<double>::infinity(), hi = -lo;");
+        code.push_back("for (auto i = std::size_t {0}; i < n; ++i) {");
+        code.push_back("\tconst auto x = static_cast<double>(" + column.at("i") + ");");
+        code.push_back("\tlo = x < lo ? x : lo;");
+        code.push_back("\thi = x > hi ? x : hi;");
+        code.push_back("}");
+    }
+    code.push_back("const auto bins = std::int64_t {" + std::to_string(bins) + "};");
+    code.push_back("const auto scale = hi > lo ? static_cast<double>(bins) / (hi - lo) : 0.0;");
+    code.push_back("std::vector<std::int64_t> count(bins + 1, 0);");
+    code.push_back("for (auto i = std::size_t {0}; i < n; ++i) {");
+    code.push_back("\tconst auto x = static_cast<double>(" + column.at("i") + ");");
+    code.push_back("\t++count[x >= lo && x <= hi ? "
+                   "std::min(static_cast<std::int64_t>((x - lo) * scale), bins - 1) : bins];");
+    code.push_back("}");
+    code.push_back(out + ".resize(bins);");
+    code.push_back("for (auto b = std::int64_t {0}; b < bins; ++b) {" + out + "[b] = static_cast<" +
+                   out_type + ">(count[b]);}");
 }
 
 static void always_same_code(StepInfo& info) {
@@ -606,29 +3935,737 @@ namespace step {
     KEY(check)
     KEY(check_data)
     KEY(reset)
+    KEY(reduce)
+    KEY(scale)
+    KEY(offset)
+    KEY(sort)
+    KEY(scan)
+    KEY(histogram)
 } // namespace step
 
-int main() {
+// registers all example steps; returns false if the registry is invalid
+static bool register_steps(Registry& reg) {
+    reg.reg(step::print_number, print_number_info, print_number, print_number_code);
+    reg.reg(step::hello_world, always_same_code, hello_world, hello_world_code);
+    reg.reg(step::set_values, add_values_info, add_values, add_values_code);
+    reg.reg(step::sum, sum_info, calculate_sum, calculate_sum_code);
+    reg.reg(step::product, product_info, calculate_product, calculate_product_code);
+    reg.reg(step::print, always_same_code, print_value, print_value_code);
+    reg.reg(step::print_data, always_same_code, print_data, print_data_code);
+    reg.reg(step::reset, always_same_code, clear_values, clear_values_code);
+    reg.reg(step::check, check_value_info, check_value, check_value_code);
+    reg.reg(step::check_data, check_data_info, check_data, check_data_code);
+    reg.reg(step::reduce, reduce_info, reduce, reduce_code);
+    reg.reg(step::scale, transform_info, scale_values, scale_values_code);
+    reg.reg(step::offset, transform_info, offset_values, offset_values_code);
+    reg.reg(step::sort, sort_info, sort_values, sort_values_code);
+    reg.reg(step::scan, scan_info, scan_values, scan_values_code);
+    reg.reg(step::histogram, histogram_info, histogram, histogram_code);
+
+    return reg.validate();
+}
+
+// ---------------------------- Benchmarks ----------------------------
+
+// runs the function and prints its run time
+template <typename FUNC> static void measure(const char* name, FUNC func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << name << "\t"
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms\n";
+}
+
+// returns the number of bytes allocated on the heap; 0 if unknown
+static std::size_t heap_usage() {
+#ifdef __GLIBC__
+    const auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// fills the recipe with a machine-generated list of the given number of steps
+// the recipe repeats a few configurations, like the recipes produced by other tools
+static void make_benchmark_recipe(const Registry& reg, unsigned int steps, Recipe& recipe) {
+    const auto set_values = reg.get_step(step::set_values).value();
+    const auto sum        = reg.get_step(step::sum).value();
+    const auto reduce     = reg.get_step(step::reduce).value();
+    const auto check      = reg.get_step(step::check_data).value();
+    const auto scale      = reg.get_step(step::scale).value();
+    const auto print      = reg.get_step(step::print).value();
+
+    for (auto i = 0u; i < steps; ++i) {
+        switch (i % 6) {
+        case 0: {
+            const auto index = recipe.add_step(set_values);
+            recipe.get(index).value()->set_config(conf::add_values::cnt,
+                                                  std::int64_t {(i / 6) % 4 * 100 + 100});
+            break;
+        }
+        case 1:
+            recipe.add_step(check);
+            break;
+        case 2: {
+            const auto index = recipe.add_step(scale);
+            recipe.get(index).value()->set_config(conf::transform::value, 0.5);
+            break;
+        }
+        case 3:
+            recipe.add_step(sum);
+            break;
+        case 4:
+            recipe.add_step(reduce);
+            break;
+        default:
+            recipe.add_step(print);
+            break;
+        }
+    }
+}
+
+// measures code generation of a recipe with the given number of steps
+static void benchmark_codegen(const Registry& reg,
+                              unsigned int steps,
+                              const std::filesystem::path& dir) {
+    Recipe recipe;
+    make_benchmark_recipe(reg, steps, recipe);
+
+    std::filesystem::create_directories(dir);
+
+    auto file_size = [](const std::filesystem::path& file) {
+        return std::filesystem::exists(file) ? std::filesystem::file_size(file) : 0u;
+    };
+
+    std::cout << "steps\t" << steps << "\n";
+
+    const auto app = (dir / "bench_app.cpp").string();
+    measure("create_code", [&]() { create_code(recipe, app.c_str()); });
+    std::cout << "\tsize " << file_size(app) << " bytes\n";
+
+    const auto app_2  = (dir / "bench_app_2.cpp").string();
+    const auto header = (dir / "bench_header.h").string();
+    measure("create_code_func", [&]() { create_code_func(recipe, app_2.c_str(), header.c_str()); });
+    std::cout << "\tsize " << file_size(app_2) + file_size(header) << " bytes\n";
+
+    CodeSettings settings;
+    settings.units = 8;
+    measure("create_code_func, 8 units",
+            [&]() { create_code_func(recipe, app_2.c_str(), header.c_str(), settings); });
+    auto size = file_size(app_2) + file_size(header);
+    for (auto unit = 0u; unit < settings.units; ++unit)
+        size += file_size(code_unit_file(header.c_str(), unit));
+    std::cout << "\tsize " << size << " bytes\n";
+}
+
+// measures the read bandwidth of memory on each NUMA node from the threads of each node,
+// then the sum of a column allocated with each placement
+static void benchmark_numa(std::int64_t elements) {
+    const auto& topology = numa_topology();
+    std::cout << "nodes\t" << topology.nodes() << "\n";
+
+    auto gb_per_s = [](std::size_t bytes, std::chrono::nanoseconds time) {
+        return static_cast<double>(bytes) /
+               static_cast<double>(std::max<long long>(time.count(), 1));
+    };
+
+    // best of a few runs
+    auto fastest = [](auto func) {
+        auto best = std::chrono::nanoseconds::max();
+        for (auto r = 0; r < 3; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now() - start));
+        }
+        return best;
+    };
+
+#ifdef __linux__
+    const auto bytes = sizeof(float) * static_cast<std::size_t>(elements);
+    for (auto m = 0u; m < topology.nodes(); ++m) {
+        auto data = mapped_allocate<float>(elements, MemorySettings {});
+        if (topology.nodes() > 1)
+            bind_memory(data.get(), bytes, mpol_bind, std::uint64_t {1} << topology._ids[m]);
+        std::fill_n(data.get(), elements, 1.0f);
+
+        for (auto n = 0u; n < topology.nodes(); ++n) {
+            const auto threads = std::max<std::int64_t>(1, std::ssize(topology._cpus[n]));
+            std::vector<double> partial(threads);
+
+            const auto time = fastest([&]() {
+                std::vector<std::thread> pool;
+                for (auto t = std::int64_t {0}; t < threads; ++t) {
+                    pool.emplace_back([&, t]() {
+                        bind_thread_to_node(n);
+                        const auto* values = data.get();
+                        auto acc           = 0.0;
+                        for (auto i = elements * t / threads; i < elements * (t + 1) / threads; ++i)
+                            acc += values[i];
+                        partial[t] = acc;
+                    });
+                }
+                for (auto& thread : pool)
+                    thread.join();
+            });
+
+            std::cout << "memory on node " << topology._ids[m] << "\tthreads on node "
+                      << topology._ids[n] << "\t" << gb_per_s(bytes, time) << " GB/s\n";
+        }
+    }
+#endif
+
+    for (const auto huge_pages : {false, true}) {
+        for (auto p = 0u; p < std::size(placement_names); ++p) {
+            Model m;
+            m._memory = {static_cast<Placement>(p), huge_pages};
+
+            Conf conf;
+            conf[conf::add_values::cnt] = elements;
+            add_values(conf, m);
+
+            const auto time = fastest([&]() { calculate_sum(conf, m); });
+            std::cout << placement_names[p] << (huge_pages ? ", huge pages" : "") << "\t"
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(time).count()
+                      << " ms\t" << gb_per_s(sizeof(float) * elements, time) << " GB/s\n";
+        }
+    }
+}
+
+// measures the throughput of sort, scan and histogram and of their standard library counterparts
+static void benchmark_data_steps(std::int64_t elements) {
+    std::mt19937 random {42};
+    std::uniform_real_distribution<float> distribution {-1000.0f, 1000.0f};
+    std::vector<float> values(elements);
+    for (auto& v : values)
+        v = distribution(random);
+
+    // stores the values in the default column
+    auto fill = [&values](Model& m) {
+        auto& data = std::get<ChunkedArray<float>>(m.column(Model::default_column, 0));
+        data.resize(std::ssize(values));
+        for (auto c = std::int64_t {0}; c < data.chunk_count(); ++c)
+            std::copy_n(values.data() + c * data.chunk_elements, data.chunk_size(c), data.chunk(c));
+    };
+
+    auto time = [](auto func) {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    };
+
+    auto report = [elements](const char* name, std::chrono::nanoseconds ns) {
+        const auto ms   = std::chrono::duration_cast<std::chrono::milliseconds>(ns).count();
+        const auto rate = static_cast<double>(elements) * 1000.0 / static_cast<double>(ns.count());
+        std::cout << name << "\t" << ms << " ms\t" << rate << " M elements/s\n";
+    };
+
+    auto column = [](Model& m, const char* name) -> const ChunkedArray<float>& {
+        return std::get<ChunkedArray<float>>(*m.find_column(name));
+    };
+
+    std::cout << "elements\t" << elements << "\n";
+    {
+        auto expected = values;
+        report("std::sort", time([&]() { std::sort(expected.begin(), expected.end()); }));
+
+        Model m;
+        fill(m);
+        report("sort", time([&]() { sort_values(Conf {}, m); }));
+
+        const auto& data = column(m, Model::default_column);
+        auto same        = true;
+        for (auto i = std::int64_t {0}; i < elements; ++i)
+            same = same && data[i] == expected[i];
+        std::cout << "\t" << (same ? "same order" : "different order") << "\n";
+    }
+    {
+        std::vector<float> expected(elements);
+        report("std::inclusive_scan",
+               time([&]() {
+                   std::inclusive_scan(values.begin(), values.end(), expected.begin());
+               }));
+
+        Model m;
+        fill(m);
+        report("scan", time([&]() { scan_values(Conf {}, m); }));
+
+        // the step sums in double, std::inclusive_scan in float
+        std::cout << "\tlast " << column(m, Model::default_column)[elements - 1] << ", "
+                  << expected.back() << "\n";
+    }
+    {
+        Conf conf;
+        conf[conf::histogram::bins] = std::int64_t {256};
+        conf[conf::histogram::min]  = -1000.0;
+        conf[conf::histogram::max]  = 1000.0;
+
+        std::vector<std::int64_t> expected(256, 0);
+        report("histogram loop", time([&]() {
+                   const auto scale = 256.0 / 2000.0;
+                   for (const auto v : values) {
+                       const auto x = static_cast<double>(v);
+                       if (x >= -1000.0 && x <= 1000.0)
+                           ++expected[std::min(static_cast<std::int64_t>((x + 1000.0) * scale),
+                                               std::int64_t {255})];
+                   }
+               }));
+
+        Model m;
+        fill(m);
+        report("histogram", time([&]() { histogram(conf, m); }));
+
+        const auto& counts = std::get<ChunkedArray<std::int64_t>>(*m.find_column("data_histogram"));
+        auto same          = true;
+        for (auto b = 0; b < 256; ++b)
+            same = same && counts[b] == expected[b];
+        std::cout << "\t" << (same ? "same counts" : "different counts") << "\n";
+    }
+}
+
+// measures memory and iteration of a recipe with the given number of steps
+// compared to a list storing a RecipeStep pointer and a Conf object per step
+static void benchmark_recipe_storage(const Registry& reg, unsigned int steps) {
+    std::cout << "steps\t" << steps << "\n";
+
+    auto   heap = heap_usage();
+    Recipe recipe;
+    make_benchmark_recipe(reg, steps, recipe);
+    const auto recipe_bytes = heap_usage() - heap;
+
+    heap = heap_usage();
+    std::vector<std::pair<const RecipeStep*, Conf>> list;
+    for (const auto& s : recipe.all())
+        list.emplace_back(s._step, s._config);
+    const auto list_bytes = heap_usage() - heap;
+
+    std::cout << "Conf objects\t" << recipe.conf_count() << "\n";
+    if (recipe_bytes != 0 && list_bytes != 0) {
+        std::cout << "recipe\t" << recipe_bytes << " bytes\n";
+        std::cout << "list\t" << list_bytes << " bytes\n";
+    }
+
+    // every pass reads the step and a key of each step, like running the recipe does
+    constexpr auto passes = 10;
+    std::int64_t   check  = 0;
+    measure("iterate recipe", [&]() {
+        for (auto p = 0; p < passes; ++p)
+            for (const auto& s : recipe.all())
+                check +=
+                    s._config.get_value(conf::add_values::cnt, std::int64_t {1}) + *s._step->_name;
+    });
+    measure("iterate list", [&]() {
+        for (auto p = 0; p < passes; ++p)
+            for (const auto& [step, config] : list)
+                check -= config.get_value(conf::add_values::cnt, std::int64_t {1}) + *step->_name;
+    });
+    std::cout << "check\t" << check << "\n";
+}
+
+#ifndef _WIN32
+
+// measures a recipe writing and reducing a column of the given number of elements
+// with run() and with run_sharded() for growing numbers of workers
+static void benchmark_sharding(const Registry& reg, std::int64_t elements) {
+    Recipe recipe;
+    recipe.add_step(reg.get_step(step::set_values).value());
+    recipe.get(0).value()->set_config(conf::add_values::cnt, elements);
+    recipe.add_step(reg.get_step(step::scale).value());
+    recipe.get(1).value()->set_config(conf::transform::value, 0.5);
+    recipe.add_step(reg.get_step(step::sum).value());
+    recipe.add_step(reg.get_step(step::print).value());
+
+    auto ignore_progress = [](unsigned int, const char*) {};
+    auto ignore_key      = [](const char*, const ConfValue&) {};
+    auto ignore_time     = [](long long) {};
+
+    std::cout << "elements\t" << elements << "\n";
+    measure("run", [&]() { run(recipe, ignore_progress, ignore_key, ignore_time); });
+
+    const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (auto workers = 1u; workers <= std::max(hardware, 2u); workers *= 2) {
+        const auto name = "run_sharded, " + std::to_string(workers) + " workers";
+        measure(name.c_str(),
+                [&]() { run_sharded(recipe, workers, ignore_progress, ignore_key, ignore_time); });
+    }
+}
+
+#endif
+
+// ---------------------------- Regression Suite ----------------------------
+
+#ifdef LAB_BENCH
+
+// the build of lab_bench defines the compiler of the generated code and the baseline file
+#ifndef LAB_BENCH_COMPILER
+#define LAB_BENCH_COMPILER "c++"
+#endif
+#ifndef LAB_BENCH_BASELINE
+#define LAB_BENCH_BASELINE "bench_baseline.txt"
+#endif
+
+// settings of the regression suite
+struct BenchSettings {
+    // command compiling a generated program; the source and "-o <exe>" are appended
+    std::string compiler = LAB_BENCH_COMPILER " -O2 -std=c++20 -pthread";
+    // directory for the generated programs
+    std::filesystem::path work_dir = std::filesystem::temp_directory_path() / "lab_regression";
+    // file of the reference ratios
+    std::filesystem::path baseline = LAB_BENCH_BASELINE;
+    // a ratio is a regression if it exceeds the reference by this factor
+    double threshold = 1.75;
+    // number of repetitions; the median counts
+    unsigned int repetitions = 9;
+};
+
+// recipe of the regression suite; fill adds the steps for the given number of elements
+struct BenchRecipe {
+    const char* _name;
+    void (*_fill)(const Registry&, std::int64_t, Recipe&);
+};
+
+// adds a step with the given configuration
+static void add_bench_step(const Registry& reg,
+                           Recipe& recipe,
+                           const char* id,
+                           std::initializer_list<std::pair<const char*, ConfValue>> conf = {}) {
+    const auto index = recipe.add_step(reg.get_step(id).value());
+    for (const auto& [key, v] : conf)
+        recipe.get(index).value()->set_config(key, v);
+}
+
+// every recipe ends with a print, so the generated programs can't drop the work
+static constexpr BenchRecipe bench_recipes[] = {
+    {"sum",
+     [](const Registry& reg, std::int64_t n, Recipe& recipe) {
+         add_bench_step(reg, recipe, step::set_values, {{conf::add_values::cnt, n}});
+         add_bench_step(reg, recipe, step::sum);
+         add_bench_step(reg, recipe, step::print);
+     }},
+    {"elementwise",
+     [](const Registry& reg, std::int64_t n, Recipe& recipe) {
+         add_bench_step(reg, recipe, step::set_values, {{conf::add_values::cnt, n}});
+         add_bench_step(reg, recipe, step::scale, {{conf::transform::value, 0.5}});
+         add_bench_step(reg, recipe, step::offset, {{conf::transform::value, 1.0}});
+         add_bench_step(reg,
+                        recipe,
+                        step::reduce,
+                        {{conf::reduce::mean, std::int64_t {1}},
+                         {conf::reduce::max, std::int64_t {1}}});
+         add_bench_step(reg, recipe, step::print, {{conf::model::result, "data_mean"}});
+     }},
+    {"sort",
+     [](const Registry& reg, std::int64_t n, Recipe& recipe) {
+         add_bench_step(reg, recipe, step::set_values, {{conf::add_values::cnt, n}});
+         add_bench_step(reg, recipe, step::scale, {{conf::transform::value, -1.0}});
+         add_bench_step(reg, recipe, step::sort);
+         add_bench_step(reg, recipe, step::sum);
+         add_bench_step(reg, recipe, step::print);
+     }},
+    {"scan_histogram",
+     [](const Registry& reg, std::int64_t n, Recipe& recipe) {
+         add_bench_step(reg, recipe, step::set_values, {{conf::add_values::cnt, n}});
+         add_bench_step(reg, recipe, step::scan);
+         add_bench_step(reg, recipe, step::histogram, {{conf::histogram::bins, std::int64_t {64}}});
+         add_bench_step(reg, recipe, step::sum, {{conf::model::column, "data_histogram"}});
+         add_bench_step(reg, recipe, step::print);
+     }},
+};
+
+// numbers of elements every recipe runs with
+static constexpr std::int64_t bench_sizes[] = {
+    std::int64_t {1} << 16, std::int64_t {1} << 20, std::int64_t {1} << 23};
+
+// returns the time of the function in ns
+template <typename FUNC> static long long time_once(FUNC func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// returns the median of the values
+static double median(std::vector<double> values) {
+    const auto middle = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+// elements of the calibration loop
+static constexpr std::int64_t bench_calibration_elements = std::int64_t {1} << 22;
+
+// fixed work the times of run() are divided by, so they compare across machines and loads;
+// like the recipes it writes a column and reduces it
+static void calibration_loop() {
+    std::vector<float> values(bench_calibration_elements);
+    for (auto i = std::size_t {0}; i < values.size(); ++i)
+        values[i] = static_cast<float>(i) * 0.5f + 1.0f;
+    volatile const auto sum = std::accumulate(values.begin(), values.end(), 0.0);
+    (void)sum;
+}
+
+// runs the recipe with run(); the output of the steps is discarded
+// returns the sum of the times of the steps in ns; nullopt if a step stops the recipe
+static std::optional<long long> run_quiet(Recipe& recipe, bool lazy) {
+    std::ostringstream sink;
+    auto* const previous = std::cout.rdbuf(sink.rdbuf());
+    auto total           = 0LL;
+    auto steps           = 0u;
+    run(
+        recipe,
+        [](unsigned int, const char*) {},
+        [](const char*, const ConfValue&) {},
+        [&](long long ns) {
+            total += ns;
+            ++steps;
+        },
+        lazy);
+    std::cout.rdbuf(previous);
+    if (steps != recipe.count())
+        return std::nullopt;
+    return total;
+}
+
+// generated program of the regression suite
+struct BenchProgram {
+    // runs the program; the output is written to _output
+    std::string _command;
+    std::filesystem::path _output;
+};
+
+// generates the instrumented program of the recipe with create_code, or with create_code_func if
+// split is set, and compiles it; nullopt if it doesn't compile
+static std::optional<BenchProgram> build_generated(Recipe& recipe,
+                                                   bool split,
+                                                   const std::string& name,
+                                                   const BenchSettings& settings) {
+    const auto base = settings.work_dir / name;
+    auto exe        = base;
+#ifdef _WIN32
+    exe += ".exe";
+#endif
+    const auto src    = std::filesystem::path(base).replace_extension(".cpp");
+    const auto header = std::filesystem::path(base).replace_extension(".h");
+    const auto out    = std::filesystem::path(base).replace_extension(".txt");
+
+    // the programs report the times of their steps, so the start of the process isn't timed
+    CodeSettings code_settings;
+    code_settings.instrument = true;
+    if (split)
+        create_code_func(recipe, src.string().c_str(), header.string().c_str(), code_settings);
+    else
+        create_code(recipe, src.string().c_str(), code_settings);
+
+    const auto compile =
+        settings.compiler + " \"" + src.string() + "\" -o \"" + exe.string() + "\"";
+    if (std::system(compile.c_str()) != 0)
+        return std::nullopt;
+
+    return BenchProgram {"\"" + exe.string() + "\" > \"" + out.string() + "\" 2>&1", out};
+}
+
+// runs the program; returns the sum of the times it reports for the steps in ns
+// nullopt if it fails or doesn't report the given number of steps, as when a step stops it
+static std::optional<long long> run_generated(const BenchProgram& program, unsigned int steps) {
+    if (std::system(program._command.c_str()) != 0)
+        return std::nullopt;
+
+    std::ifstream file_stream {program._output, std::ifstream::in | std::ifstream::binary};
+    const std::string text {std::istreambuf_iterator<char> {file_stream}, {}};
+
+    const std::string_view prefix = report_time_prefix;
+    auto total                    = 0LL;
+    auto reported                 = 0u;
+    for (auto at = text.find(prefix); at != std::string::npos; at = text.find(prefix, at)) {
+        at += prefix.size();
+        auto ns        = 0LL;
+        const auto res = std::from_chars(text.data() + at, text.data() + text.size(), ns);
+        if (res.ec != std::errc {})
+            return std::nullopt;
+        total += ns;
+        ++reported;
+    }
+    if (reported != steps)
+        return std::nullopt;
+    return total;
+}
+
+// loads the reference ratios by name; empty if the file can't be read
+static std::map<std::string, double> load_baseline(const std::filesystem::path& file) {
+    std::map<std::string, double> ratios;
+    std::ifstream file_stream {file, std::ifstream::in};
+    std::string line;
+    while (std::getline(file_stream, line)) {
+        const auto sep = line.rfind(':');
+        if (sep == std::string::npos)
+            continue;
+        try {
+            ratios[line.substr(0, sep)] = std::stod(line.substr(sep + 1));
+        } catch (...) {
+        }
+    }
+    return ratios;
+}
+
+// stores the reference ratios to text file
+static void store_baseline(const std::filesystem::path& file,
+                           const std::map<std::string, double>& ratios) {
+    std::ofstream file_stream {file, std::ofstream::out};
+    for (const auto& [name, ratio] : ratios)
+        file_stream << name << ":" << ratio << NL;
+}
+
+// runs every recipe of the catalog at every size interpreted, lazily interpreted and as both
+// generated programs; every path is timed as the sum of the times of its steps
+// the time of run() is divided by the time of a calibration loop and the other times by the time
+// of run() in the same repetition, so the ratios hardly depend on the machine and its load
+// returns false if a ratio regressed against the baseline or a program failed
+// with update set, the ratios are stored as the new baseline instead
+static bool regression_suite(const Registry& reg, bool update, const BenchSettings& settings = {}) {
+    std::filesystem::create_directories(settings.work_dir);
+
+    const auto baseline = load_baseline(settings.baseline);
+    std::map<std::string, double> ratios;
+    auto ok = true;
+
+    auto report = [&](const std::string& name, double ratio, const char* reference) {
+        ratios[name] = ratio;
+        std::cout << name << "\t" << ratio << "x " << reference;
+
+        const auto ref = baseline.find(name);
+        if (ref == baseline.end()) {
+            std::cout << "\tnew\n";
+            return;
+        }
+        std::cout << "\tbaseline " << ref->second << "x " << reference;
+        if (ratio > ref->second * settings.threshold) {
+            std::cout << "\tREGRESSION";
+            ok = false;
+        }
+        std::cout << NL;
+    };
+
+    for (const auto& bench : bench_recipes) {
+        for (const auto n : bench_sizes) {
+            Recipe recipe;
+            bench._fill(reg, n, recipe);
+
+            const auto name  = std::string(bench._name) + "/" + std::to_string(n);
+            const auto file  = std::string(bench._name) + "_" + std::to_string(n);
+            const auto app   = build_generated(recipe, false, file, settings);
+            const auto app_2 = build_generated(recipe, true, file + "_2", settings);
+
+            // the paths are timed in turns, so a change of the load of the machine affects all
+            // of them; the median of the ratios of the repetitions counts
+            std::vector<double> runs, lazy, apps, apps_2;
+            auto failed = !app || !app_2;
+            for (auto rep = 0u; !failed && rep < std::max(settings.repetitions, 1u); ++rep) {
+                const auto t_calibration = time_once(calibration_loop);
+                const auto t_run         = run_quiet(recipe, false);
+                const auto t_lazy        = run_quiet(recipe, true);
+                const auto t_app         = run_generated(*app, recipe.count());
+                const auto t_app_2       = run_generated(*app_2, recipe.count());
+                failed                   = !t_run || !t_lazy || !t_app || !t_app_2;
+                if (failed)
+                    break;
+
+                const auto reference = static_cast<double>(std::max(t_run.value(), 1LL));
+                runs.push_back(reference / static_cast<double>(std::max(t_calibration, 1LL)));
+                lazy.push_back(static_cast<double>(t_lazy.value()) / reference);
+                apps.push_back(static_cast<double>(t_app.value()) / reference);
+                apps_2.push_back(static_cast<double>(t_app_2.value()) / reference);
+            }
+
+            if (failed) {
+                std::cout << name << "\tfailed\n";
+                ok = false;
+                continue;
+            }
+            report(name + "/run", median(runs), "calibration");
+            report(name + "/lazy", median(lazy), "run");
+            report(name + "/my_app", median(apps), "run");
+            report(name + "/my_app_2", median(apps_2), "run");
+        }
+    }
+
+    if (update) {
+        store_baseline(settings.baseline, ratios);
+        std::cout << "Baseline stored to " << settings.baseline.string() << NL;
+        return true;
+    }
+    return ok;
+}
+
+#endif
+
+int main(int argc, char** argv) {
+
+    auto has_arg = [argc, argv](const char* arg) {
+        for (auto i = 1; i < argc; ++i)
+            if (std::strcmp(argv[i], arg) == 0)
+                return true;
+        return false;
+    };
+
+    // "lab lazy" fuses element-wise steps into the steps consuming their results
+    const auto lazy = has_arg("lazy");
+
+    // "lab interleave", "lab local" and "lab huge_pages" select the allocation of the data
+    MemorySettings memory;
+    if (has_arg("interleave"))
+        memory.placement = Placement::interleave;
+    if (has_arg("local"))
+        memory.placement = Placement::local;
+    memory.huge_pages = has_arg("huge_pages");
 
     Registry reg;
     {
-        reg.reg(step::print_number, print_number_info, print_number, print_number_code);
-        reg.reg(step::hello_world, always_same_code, hello_world, hello_world_code);
-        reg.reg(step::set_values, add_values_info, add_values, add_values_code);
-        reg.reg(step::sum, always_same_code, calculate_sum, calculate_sum_code);
-        reg.reg(step::product, always_same_code, calculate_product, calculate_product_code);
-        reg.reg(step::print, always_same_code, print_value, print_value_code);
-        reg.reg(step::print_data, always_same_code, print_data, print_data_code);
-        reg.reg(step::reset, always_same_code, clear_values, clear_values_code);
-        reg.reg(step::check, check_value_info, check_value, check_value_code);
-        reg.reg(step::check_data, check_data_info, check_data, check_data_code);
-
-        const auto valid = reg.validate();
+        const auto valid = register_steps(reg);
         assert(valid);
         if (!valid)
             return 1;
     }
 
+#ifdef LAB_BENCH
+    // "lab_bench" compares the catalog with the baseline; "lab_bench update" stores a new one
+    return regression_suite(reg, has_arg("update")) ? 0 : 1;
+#endif
+
+    // "lab bench_codegen" measures code generation of a recipe of a million steps
+    if (has_arg("bench_codegen")) {
+        benchmark_codegen(reg, 1'000'000, std::filesystem::temp_directory_path() / "lab_bench");
+        return 0;
+    }
+
+#ifndef _WIN32
+    // "lab bench_shard" compares running a large recipe in one and in several processes
+    if (has_arg("bench_shard")) {
+        benchmark_sharding(reg, std::int64_t {1} << 27);
+        return 0;
+    }
+#endif
+
+    // "lab bench_numa" measures the bandwidth of the NUMA nodes and of the placements
+    if (has_arg("bench_numa")) {
+        benchmark_numa(std::int64_t {1} << 26);
+        return 0;
+    }
+
+    // "lab bench_steps" measures sort, scan and histogram
+    if (has_arg("bench_steps")) {
+        benchmark_data_steps(std::int64_t {1} << 24);
+        return 0;
+    }
+
+    // "lab bench_recipe" measures memory and iteration of a recipe of a million steps
+    if (has_arg("bench_recipe")) {
+        benchmark_recipe_storage(reg, 1'000'000);
+        return 0;
+    }
+
     Recipe recipe;
     {
         auto add_step = [&](const char* id) {
@@ -637,7 +4674,7 @@ int main() {
             if (res) recipe.add_step(res.value());
         };
 
-        auto add_step_configure = [&](const char* id, const char* key, float v) {
+        auto add_step_configure = [&](const char* id, const char* key, ConfValue v) {
             auto res = reg.get_step(id);
             assert(res);
             if (res) {
@@ -663,28 +4700,98 @@ int main() {
         add_step(step::product);
         add_step(step::print);
 
+        // a second column of another type, reduced into its own result slot
+        add_step_configure(step::set_values, conf::add_values::cnt, 5);
+        recipe.get(recipe.count() - 1).value()->set_config(conf::model::column, "prices");
+        recipe.get(recipe.count() - 1).value()->set_config(conf::model::type, "f64");
+        add_step_configure(step::sum, conf::model::column, "prices");
+        recipe.get(recipe.count() - 1).value()->set_config(conf::model::result, "total");
+        add_step_configure(step::print, conf::model::result, "total");
+
+        // several statistics of the column in one pass
+        add_step_configure(step::reduce, conf::model::column, "prices");
+        recipe.get(recipe.count() - 1).value()->set_config(conf::reduce::mean, 1);
+        recipe.get(recipe.count() - 1).value()->set_config(conf::reduce::variance, 1);
+        recipe.get(recipe.count() - 1).value()->set_config(conf::reduce::max, 1);
+        add_step_configure(step::print, conf::model::result, "prices_mean");
+        add_step_configure(step::print, conf::model::result, "prices_variance");
+        add_step_configure(step::print, conf::model::result, "prices_max");
+
+        // element-wise steps; fused into the reduction when running lazily
+        add_step_configure(step::set_values, conf::add_values::cnt, 1000);
+        recipe.get(recipe.count() - 1).value()->set_config(conf::model::column, "signal");
+        add_step_configure(step::scale, conf::model::column, "signal");
+        recipe.get(recipe.count() - 1).value()->set_config(conf::transform::value, 0.5);
+        add_step_configure(step::offset, conf::model::column, "signal");
+        recipe.get(recipe.count() - 1).value()->set_config(conf::transform::value, 1.0);
+        add_step_configure(step::reduce, conf::model::column, "signal");
+        recipe.get(recipe.count() - 1).value()->set_config(conf::reduce::sum, 1);
+        add_step_configure(step::print, conf::model::result, "signal_sum");
+
+        // sorted, summed up and counted in bins
+        add_step_configure(step::set_values, conf::add_values::cnt, 8);
+        recipe.get(recipe.count() - 1).value()->set_config(conf::model::column, "ramp");
+        add_step_configure(step::scale, conf::model::column, "ramp");
+        recipe.get(recipe.count() - 1).value()->set_config(conf::transform::value, -1.0);
+        add_step_configure(step::sort, conf::model::column, "ramp");
+        add_step_configure(step::scan, conf::model::column, "ramp");
+        add_step_configure(step::histogram, conf::model::column, "ramp");
+        recipe.get(recipe.count() - 1).value()->set_config(conf::histogram::bins, 4);
+        add_step_configure(step::print_data, conf::model::column, "ramp_histogram");
+        add_step_configure(step::sum, conf::model::column, "ramp");
+        recipe.get(recipe.count() - 1).value()->set_config(conf::model::result, "ramp_total");
+        add_step_configure(step::print, conf::model::result, "ramp_total");
+
         recipe.store("test.recipe");
     }
 
     {
         auto print_progress = [](unsigned int s, const char* name) {
-            std::cout << "\n\033[1;32mStep " << s << " :\t\033[0m\033[1;36m" << name << "\033[0m\n";
+            std::cout << report_step(s, name);
+        };
+
+        auto print_keys = [](const char* key, const ConfValue& v) {
+            std::cout << report_key(key, v);
         };
 
-        auto print_keys = [](const char* key, float v) {
-            std::cout << "\t\t\033[1;33mKey: " << key << ", Value: " << v << "\033[0m \n";
+        auto print_time = [](long long ns) {
+            std::cout << report_time_prefix << ns << report_time_suffix;
         };
 
-        auto print_time = [](long long ms) {
-            std::cout << "\n\t\t\033[1;37mTime: " << ms << " ns\t\033[0m\n";
+#ifndef _WIN32
+        // "lab shard" runs the data-parallel steps in worker processes
+        if (has_arg("shard")) {
+            if (!run_sharded(recipe, 4, print_progress, print_keys, print_time))
+                std::cout << "The workers could not be started.\n";
+        } else
+#endif
+            run(recipe, print_progress, print_keys, print_time, lazy, memory);
+    }
+
+    // "lab tune" benchmarks the code variants and stores the winners in the tuning database
+    TuningDB tuning;
+    if (has_arg("tune")) {
+        auto print_variant = [](const char* name,
+                                unsigned int bucket,
+                                const char* variant,
+                                long long ns) {
+            std::cout << "\033[1;36m" << name << "\033[0m\tbucket " << bucket << "\t" << variant
+                      << "\t" << ns << " ns\n";
         };
 
-        run(recipe, print_progress, print_keys, print_time);
+        tune(reg, step::set_values, conf::add_values::cnt, tuning, TuneSettings {}, print_variant);
+        tuning.store("tuning.db");
+    } else {
+        tuning.load("tuning.db");
     }
 
-    create_code(recipe, "my_app.cpp");
+    CodeSettings code_settings {&tuning, lazy};
+    // "lab instrument" writes programs reporting the time of every step at exit
+    code_settings.instrument = has_arg("instrument");
+
+    create_code(recipe, "my_app.cpp", code_settings);
 
-    create_code_func(recipe, "my_app_2.cpp", "my_header.h");
+    create_code_func(recipe, "my_app_2.cpp", "my_header.h", code_settings);
 
     return 0;
 }